@@ -2,6 +2,9 @@
 #include "item.hpp"
 #include "game.hpp"
 
+Action::Action(coordinates<size_t> target, Unit& executing_unit):
+    target_(std::move(target)), executing_unit_(executing_unit), executing_handle_(executing_unit.get_handle()) {}
+
 const coordinates<size_t>& Action::target() const {
     return target_;
 }
@@ -51,10 +54,9 @@ void WeaponAction::execute(Game &game, coordinates<size_t> unit_location) {
 
         } else { // Area of effect attack
             Map& map = game.get_map();
-            std::vector<coordinates<size_t>> affected_coords = map.get_aoe_affected_coords(target_, weapon_.get_aoe());
+            std::vector<coordinates<size_t>> affected_coords = map.get_aoe_affected_unit_coords(target_, weapon_.get_aoe());
             for (const auto& coords : affected_coords) {
                 Unit* target_unit = map.get_unit(coords);
-                if (target_unit == nullptr) continue;
 
                 // Distance is calculated from the origin of the AoE (aka target), not from the unit that executes this action
                 int distance = target_.distance_to(coords);
@@ -86,10 +88,9 @@ void HealingAction::execute(Game &game, coordinates<size_t> unit_location) {
 
         } else { // AoE healing
             Map& map = game.get_map();
-            std::vector<coordinates<size_t>> affected_coords = map.get_aoe_affected_coords(target_, healing_item_.get_aoe());
+            std::vector<coordinates<size_t>> affected_coords = map.get_aoe_affected_unit_coords(target_, healing_item_.get_aoe());
             for (const auto& coords : affected_coords) {
                 Unit* target_unit = map.get_unit(coords);
-                if (target_unit == nullptr) continue; 
                 int healed_amount = target_unit->heal(healing_item_);
                 game.get_output_stream() << "Healed " << target_unit->get_name() << " for " << healed_amount << ".\n";
                 healed_amounts_.emplace_back(target_unit, healed_amount);
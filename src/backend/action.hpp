@@ -6,6 +6,7 @@
 #include "item.hpp"
 #include "coordinates.hpp"
 #include "building_part_type.hpp"
+#include "unit.hpp"
 
 class Game; //forward declaration
 class BuildingPart; //forward declaration
@@ -14,8 +15,7 @@ class Unit;
 
 class Action {
 public:
-    Action(coordinates<size_t> target, Unit& executing_unit):
-        target_(std::move(target)), executing_unit_(executing_unit) {}
+    Action(coordinates<size_t> target, Unit& executing_unit);
 
     virtual ~Action() = default;
 
@@ -52,9 +52,17 @@ public:
     [[nodiscard]]
     Unit& get_unit() { return executing_unit_; }
 
+    [[nodiscard]]
+    const Unit& get_unit() const { return executing_unit_; }
+
+    // The handle of the unit at the time the action was made, Game doesn't execute the action if the unit has been removed since
+    [[nodiscard]]
+    const UnitHandle& get_unit_handle() const { return executing_handle_; }
+
 protected:
     const coordinates<size_t> target_;
     Unit& executing_unit_;
+    UnitHandle executing_handle_;
     bool has_been_executed_ = false;
 };
 
@@ -93,6 +101,9 @@ public:
     [[nodiscard]]
     virtual bool is_movement() const {return false;}
 
+    [[nodiscard]]
+    const Weapon& get_weapon() const {return weapon_;}
+
 private:
     // Coordinates of the unit who does this action at the point of execution
     const Weapon& weapon_;
@@ -109,6 +120,9 @@ public:
     [[nodiscard]]
     int area_of_effect() const;
 
+    [[nodiscard]]
+    const HealingItem& get_healing_item() const {return healing_item_;}
+
     virtual void execute(Game& game, coordinates<size_t> unit_location);
     virtual void undo(Game& game);
 
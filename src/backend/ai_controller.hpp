@@ -0,0 +1,42 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief The kinds of AI that can control a team, see Game::set_ai_controlled_team
+ */
+enum class AIType {
+    // EnemyAI, a rule set that moves towards the enemies and attacks the weakest one it sees
+    rules,
+    // MctsAI, searches the team's turn with Monte Carlo tree search within a time budget
+    monte_carlo
+};
+
+/**
+ * @brief Interface of the AIs that plan the turns of a team. Game calls generate_whole_teams_turns when it's
+ * the turn of the AI's team, and the AI queues the actions of its units with Game::add_action.
+ */
+class AIController {
+public:
+    virtual ~AIController() = default;
+
+    /**
+     * @brief Generates and queues the turns of every unit of the team
+     */
+    virtual void generate_whole_teams_turns() = 0;
+
+    /**
+     * @brief Sets the amount of threads the AI plans on, 0 for the amount of hardware threads
+     */
+    virtual void set_planning_jobs(size_t jobs) = 0;
+
+    /**
+     * @brief Seed for the random choices of the AI, so the same situation gets planned the same way
+     */
+    virtual void set_planning_seed(uint64_t seed) = 0;
+
+    /**
+     * @brief The id of the team the AI controls
+     */
+    virtual int team_id() const = 0;
+};
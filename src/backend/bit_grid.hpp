@@ -0,0 +1,160 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <cassert>
+#include <bit>
+
+#include "coordinates.hpp"
+#include "bit_kernels.hpp"
+
+
+/**
+ * @brief A grid of bits packed into 64 bit words. Every row starts from a new word so whole rows
+ * can be combined with bitwise operations, one word at a time. The unused bits at the end of
+ * a row are always kept as 0.
+ */
+class BitGrid
+{
+    private:
+        size_t width_ = 0;
+        size_t height_ = 0;
+        size_t words_per_row_ = 0;
+        std::vector<uint64_t> words_;
+
+        // mask of the bits of the last word of a row that are inside of the grid
+        [[nodiscard]]
+        constexpr uint64_t last_word_mask() const noexcept
+        {
+            const size_t used_bits = width_ % 64;
+            return used_bits == 0 ? ~uint64_t{0} : ( uint64_t{1} << used_bits ) - 1;
+        }
+
+    public:
+        BitGrid() noexcept = default;
+
+        BitGrid( size_t height, size_t width, bool value = false ) : 
+            width_(width), height_(height), words_per_row_( ( width + 63 ) / 64 ), words_( words_per_row_ * height, 0 )
+        { 
+            if ( value ) fill( true );
+        }
+
+        [[nodiscard]]
+        constexpr size_t width() const noexcept { return width_; }
+
+        [[nodiscard]]
+        constexpr size_t height() const noexcept { return height_; }
+
+        [[nodiscard]]
+        constexpr size_t words_per_row() const noexcept { return words_per_row_; }
+
+        [[nodiscard]]
+        inline bool test( const size_t y, const size_t x ) const noexcept
+        {
+            return ( words_[ y * words_per_row_ + x / 64 ] >> ( x % 64 ) ) & 1;
+        }
+
+        template<typename D>
+        [[nodiscard]]
+        inline bool test( const coordinates<D>& coords ) const noexcept
+        {
+            return test( coords.y, coords.x );
+        }
+
+        inline void set( const size_t y, const size_t x ) noexcept
+        {
+            words_[ y * words_per_row_ + x / 64 ] |= uint64_t{1} << ( x % 64 );
+        }
+
+        inline void reset( const size_t y, const size_t x ) noexcept
+        {
+            words_[ y * words_per_row_ + x / 64 ] &= ~( uint64_t{1} << ( x % 64 ) );
+        }
+
+        inline void assign( const size_t y, const size_t x, const bool value ) noexcept
+        {
+            if ( value ) set( y, x );
+            else reset( y, x );
+        }
+
+        void fill( const bool value ) noexcept
+        {
+            for ( size_t y = 0; y < height_; y++ ) {
+                uint64_t* words = row( y );
+                for ( size_t i = 0; i < words_per_row_; i++ ) {
+                    words[i] = value ? ~uint64_t{0} : 0;
+                }
+                if ( value && words_per_row_ > 0 ) words[ words_per_row_ - 1 ] &= last_word_mask();
+            }
+        }
+
+        // amount of set bits in the whole grid
+        [[nodiscard]]
+        size_t count() const noexcept
+        {
+            size_t amount = 0;
+            for ( uint64_t word : words_ ) {
+                amount += std::popcount( word );
+            }
+            return amount;
+        }
+
+        [[nodiscard]]
+        inline uint64_t* row( const size_t y ) noexcept
+        {
+            return words_.data() + y * words_per_row_;
+        }
+
+        [[nodiscard]]
+        inline const uint64_t* row( const size_t y ) const noexcept
+        {
+            return words_.data() + y * words_per_row_;
+        }
+
+        [[nodiscard]]
+        inline std::vector<uint64_t>& words() noexcept { return words_; }
+
+        [[nodiscard]]
+        inline const std::vector<uint64_t>& words() const noexcept { return words_; }
+
+        // true if any bit of the grid is set
+        [[nodiscard]]
+        bool any() const noexcept
+        {
+            return BitKernels::any( words_.data(), words_.size() );
+        }
+
+        /*
+         * Combinations of two grids into <out>, see bit_kernels.hpp. All three grids have to be of the same size,
+         * <out> can be one of the other two. The unused bits at the ends of the rows stay 0 with all of them.
+         */
+
+        // Sets <out> to <a> OR <b>, e.g. the tiles that any of two units see
+        static void unite( const BitGrid& a, const BitGrid& b, BitGrid& out ) noexcept
+        {
+            assert( a.words_.size() == b.words_.size() && a.words_.size() == out.words_.size() );
+            BitKernels::unite( a.words_.data(), b.words_.data(), out.words_.data(), out.words_.size() );
+        }
+
+        // Sets <out> to <a> AND <b>
+        static void intersect( const BitGrid& a, const BitGrid& b, BitGrid& out ) noexcept
+        {
+            assert( a.words_.size() == b.words_.size() && a.words_.size() == out.words_.size() );
+            BitKernels::intersect( a.words_.data(), b.words_.data(), out.words_.data(), out.words_.size() );
+        }
+
+        // Sets <out> to <a> AND NOT <b>, e.g. "walkable and not occupied"
+        static void and_not( const BitGrid& a, const BitGrid& b, BitGrid& out ) noexcept
+        {
+            assert( a.words_.size() == b.words_.size() && a.words_.size() == out.words_.size() );
+            BitKernels::difference( a.words_.data(), b.words_.data(), out.words_.data(), out.words_.size() );
+        }
+
+        // Sets <out> to <a> XOR <b>, e.g. the tiles that turned visible or hidden between two views
+        static void symmetric_difference( const BitGrid& a, const BitGrid& b, BitGrid& out ) noexcept
+        {
+            assert( a.words_.size() == b.words_.size() && a.words_.size() == out.words_.size() );
+            BitKernels::symmetric_difference( a.words_.data(), b.words_.data(), out.words_.data(), out.words_.size() );
+        }
+};
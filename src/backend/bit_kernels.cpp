@@ -0,0 +1,142 @@
+#include "bit_kernels.hpp"
+
+#if defined(__AVX2__)
+    #define BIT_KERNELS_AVX2
+    #include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || ( defined(_M_IX86_FP) && _M_IX86_FP >= 2 )
+    #define BIT_KERNELS_SSE2
+    #include <emmintrin.h>
+#endif
+
+
+namespace BitKernels
+{
+
+namespace
+{
+
+// The operations as a scalar version and the vector versions of the instruction sets
+struct Or
+{
+    static inline uint64_t scalar( uint64_t a, uint64_t b ) noexcept { return a | b; }
+#if defined(BIT_KERNELS_AVX2)
+    static inline __m256i vector( __m256i a, __m256i b ) noexcept { return _mm256_or_si256( a, b ); }
+#elif defined(BIT_KERNELS_SSE2)
+    static inline __m128i vector( __m128i a, __m128i b ) noexcept { return _mm_or_si128( a, b ); }
+#endif
+};
+
+struct And
+{
+    static inline uint64_t scalar( uint64_t a, uint64_t b ) noexcept { return a & b; }
+#if defined(BIT_KERNELS_AVX2)
+    static inline __m256i vector( __m256i a, __m256i b ) noexcept { return _mm256_and_si256( a, b ); }
+#elif defined(BIT_KERNELS_SSE2)
+    static inline __m128i vector( __m128i a, __m128i b ) noexcept { return _mm_and_si128( a, b ); }
+#endif
+};
+
+struct AndNot
+{
+    static inline uint64_t scalar( uint64_t a, uint64_t b ) noexcept { return a & ~b; }
+    // andnot negates its first operand
+#if defined(BIT_KERNELS_AVX2)
+    static inline __m256i vector( __m256i a, __m256i b ) noexcept { return _mm256_andnot_si256( b, a ); }
+#elif defined(BIT_KERNELS_SSE2)
+    static inline __m128i vector( __m128i a, __m128i b ) noexcept { return _mm_andnot_si128( b, a ); }
+#endif
+};
+
+struct Xor
+{
+    static inline uint64_t scalar( uint64_t a, uint64_t b ) noexcept { return a ^ b; }
+#if defined(BIT_KERNELS_AVX2)
+    static inline __m256i vector( __m256i a, __m256i b ) noexcept { return _mm256_xor_si256( a, b ); }
+#elif defined(BIT_KERNELS_SSE2)
+    static inline __m128i vector( __m128i a, __m128i b ) noexcept { return _mm_xor_si128( a, b ); }
+#endif
+};
+
+template<typename Op>
+inline void apply( const uint64_t* a, const uint64_t* b, uint64_t* out, size_t words ) noexcept
+{
+    size_t i = 0;
+#if defined(BIT_KERNELS_AVX2)
+    for ( ; i + 4 <= words; i += 4 ) {
+        const __m256i va = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( a + i ) );
+        const __m256i vb = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( b + i ) );
+        _mm256_storeu_si256( reinterpret_cast<__m256i*>( out + i ), Op::vector( va, vb ) );
+    }
+#elif defined(BIT_KERNELS_SSE2)
+    for ( ; i + 2 <= words; i += 2 ) {
+        const __m128i va = _mm_loadu_si128( reinterpret_cast<const __m128i*>( a + i ) );
+        const __m128i vb = _mm_loadu_si128( reinterpret_cast<const __m128i*>( b + i ) );
+        _mm_storeu_si128( reinterpret_cast<__m128i*>( out + i ), Op::vector( va, vb ) );
+    }
+#endif
+    for ( ; i < words; i++ ) {
+        out[i] = Op::scalar( a[i], b[i] );
+    }
+}
+
+} // namespace
+
+
+void unite( const uint64_t* a, const uint64_t* b, uint64_t* out, size_t words ) noexcept
+{
+    apply<Or>( a, b, out, words );
+}
+
+
+void intersect( const uint64_t* a, const uint64_t* b, uint64_t* out, size_t words ) noexcept
+{
+    apply<And>( a, b, out, words );
+}
+
+
+void difference( const uint64_t* a, const uint64_t* b, uint64_t* out, size_t words ) noexcept
+{
+    apply<AndNot>( a, b, out, words );
+}
+
+
+void symmetric_difference( const uint64_t* a, const uint64_t* b, uint64_t* out, size_t words ) noexcept
+{
+    apply<Xor>( a, b, out, words );
+}
+
+
+bool any( const uint64_t* words, size_t size ) noexcept
+{
+    size_t i = 0;
+#if defined(BIT_KERNELS_AVX2)
+    for ( ; i + 4 <= size; i += 4 ) {
+        const __m256i v = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( words + i ) );
+        if ( !_mm256_testz_si256( v, v ) ) return true;
+    }
+#elif defined(BIT_KERNELS_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    for ( ; i + 2 <= size; i += 2 ) {
+        const __m128i v = _mm_loadu_si128( reinterpret_cast<const __m128i*>( words + i ) );
+        if ( _mm_movemask_epi8( _mm_cmpeq_epi8( v, zero ) ) != 0xFFFF ) return true;
+    }
+#endif
+    for ( ; i < size; i++ ) {
+        if ( words[i] != 0 ) return true;
+    }
+    return false;
+}
+
+
+const char* instruction_set() noexcept
+{
+#if defined(BIT_KERNELS_AVX2)
+    return "AVX2";
+#elif defined(BIT_KERNELS_SSE2)
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
+
+} // namespace BitKernels
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+
+/*
+ * Bitwise kernels over arrays of 64 bit words, used to combine the bit layers of BitGrid whole rows at a time.
+ * The loops are written with AVX2 intrinsics when the compiler targets AVX2 (-mavx2 or /arch:AVX2), with SSE2
+ * otherwise on x86, and fall back to plain 64 bit operations elsewhere. The last words that don't fill a whole
+ * vector are always handled one by one. <out> may be the same array as <a> or <b>.
+ */
+namespace BitKernels
+{
+
+// out = a | b
+void unite( const uint64_t* a, const uint64_t* b, uint64_t* out, size_t words ) noexcept;
+
+// out = a & b
+void intersect( const uint64_t* a, const uint64_t* b, uint64_t* out, size_t words ) noexcept;
+
+// out = a & ~b
+void difference( const uint64_t* a, const uint64_t* b, uint64_t* out, size_t words ) noexcept;
+
+// out = a ^ b, the bits that are set in only one of the arrays
+void symmetric_difference( const uint64_t* a, const uint64_t* b, uint64_t* out, size_t words ) noexcept;
+
+// true if any bit of the array is set
+[[nodiscard]]
+bool any( const uint64_t* words, size_t size ) noexcept;
+
+// Name of the instruction set the kernels were compiled for, "AVX2", "SSE2" or "scalar"
+[[nodiscard]]
+const char* instruction_set() noexcept;
+
+} // namespace BitKernels
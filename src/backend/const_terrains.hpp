@@ -2,6 +2,8 @@
 #define SRC_BACKEND_CONST_TERRAINS_HPP_
 
 #include <algorithm>
+#include <array>
+#include <cstdint>
 #include <memory>
 #include <unordered_map>
 
@@ -36,6 +38,45 @@ inline std::shared_ptr<const Terrain> get_terrain_from_char(char repr) {
     return (*it).second;
 }
 
+// Compact ids of the terrains above. Map stores one of these per tile instead of a shared_ptr,
+// so the id is used as an index into <id_to_terrain> and into Map's terrain property table.
+enum TerrainId : uint8_t {
+    background_id = 0,
+    wall_id,
+    mud_id,
+    water_id,
+    tree_id,
+    terrain_count
+};
+
+static const std::array<std::shared_ptr<const Terrain>, terrain_count> id_to_terrain = 
+    {
+        background,
+        wall,
+        mud,
+        water,
+        tree
+    };
+
+static const std::unordered_map<char, uint8_t> char_to_terrain_id = 
+    {
+        {'.', background_id}, 
+        {'#', wall_id}, 
+        {'-', mud_id}, 
+        {'~', water_id}, 
+        {'P', tree_id}
+    };
+
+// Returns terrain_count if the character doesn't represent any terrain
+inline uint8_t get_terrain_id_from_char(char repr) {
+    const auto it = char_to_terrain_id.find(repr);
+
+    if (it == char_to_terrain_id.cend())
+        return terrain_count;
+
+    return (*it).second;
+}
+
 static const std::unordered_map<char, int> char_to_texture_idx = 
     {
         {'.', TextureIdx::background_terrain}, 
@@ -2,6 +2,7 @@
 #include <random>
 #include <ctime>
 #include <memory>
+#include <unordered_set>
 
 #include "action.hpp"
 #include "enemy_ai.hpp"
@@ -20,13 +21,15 @@ EnemyAI::EnemyAI(Game& game, Team& team):
 }
 
 void EnemyAI::initialize_patrol_ranges() {
+    std::erase_if(patrol_ranges_, [this](const auto& range) { return !team_.has_unit(range.first); });
     for (const Unit& unit : team_.get_units()) {
-        patrol_ranges_.emplace(unit.get_id(), PatrolRange(game_.get_unit_location(unit.get_id()), map_));
+        if (unit.is_dead() || patrol_ranges_.count(unit.get_id()) != 0) continue;
+        patrol_ranges_.emplace(unit.get_id(), PatrolRange(map_.get_unit_location(&unit), map_));
     }
 }
 
 
-bool EnemyAI::is_in_units_patrol_range(const coordinates<size_t> &coords, int unit_id) {
+bool EnemyAI::is_in_units_patrol_range(const coordinates<size_t> &coords, int unit_id) const {
     const auto& range_it = patrol_ranges_.find(unit_id);
     assert(range_it != patrol_ranges_.end() && "Unit with specified ID has not had their patrol range initialized or is not part of the team");
     const PatrolRange& range = (*range_it).second;
@@ -43,46 +46,115 @@ coordinates<size_t> EnemyAI::generate_movement(Unit& unit, const coordinates<siz
     if (movement_locations.empty()) 
         return unit_loc;
 
-    std::vector<coordinates<size_t>> vision_coords = map_.tiles_unit_sees(unit_loc, unit_consts.visual_range);
-    std::vector<coordinates<size_t>> visible_enemy_coords;
-    get_visible_unit_coords(vision_coords, &visible_enemy_coords, nullptr);
+    // A unit added to the team after the turn started patrols where it is
+    if (patrol_ranges_.count(unit.get_id()) == 0) {
+        patrol_ranges_.emplace(unit.get_id(), PatrolRange(unit_loc, map_));
+    }
 
-    if (visible_enemy_coords.empty()) { // Can't see enemy
+    if (enemy_field_.empty() || enemy_field_.distance(unit_loc) == FlowField::unreachable) { // Can't see enemy or can't reach any
 
         // If unit is already inside its patrol range and has no visible enemy, just move inside the patrol range
         if (is_in_units_patrol_range(unit_loc, unit.get_id())) {
-            // Take random movement till it's inside of the patrol range
-            int checks_done = 0;
-            while (true) {
-                checks_done++;
-                // After 20 checks, there is probably not a movement available, return starting location
-                if (checks_done > 20) {
-                    chosen_movement = unit_loc;
-                    break;
-                }
-
-                chosen_movement = movement_locations[rand() % movement_locations.size()];
-
-                // Break if it's in the range
-                if (is_in_units_patrol_range(chosen_movement, unit.get_id()))
-                    break;
-
-            }
+            chosen_movement = random_patrol_movement(unit, unit_loc, movement_locations, nullptr);
         } else { // Otherwise move towards center of range
             const auto& range_it = patrol_ranges_.find(unit.get_id());
             assert(range_it != patrol_ranges_.end() && "Unit with specified ID has not had their patrol range initialized or is not part of the team");
             const PatrolRange& range = (*range_it).second;
 
-            chosen_movement = map_.fastest_movement_to_target(unit_loc, range.center, unit_consts.move_range);
+            // The actions of the units before may have changed the terrain, this search prepares itself again
+            chosen_movement = game_.get_map().fastest_movement_to_target(unit_loc, range.center, unit_consts.move_range);
         }
-    } else { //If can see enemy, move towards a random one
-        chosen_movement = map_.fastest_movement_to_target(unit_loc, visible_enemy_coords[rand() % visible_enemy_coords.size()], unit_consts.move_range);
+    } else { //If the team can see enemies, move towards the closest one
+        chosen_movement = best_step(unit, unit_loc, movement_locations);
     }
 
     return chosen_movement;
 
 }
 
+coordinates<size_t> EnemyAI::random_patrol_movement(Unit& unit, const coordinates<size_t>& unit_loc, const std::vector<coordinates<size_t>>& movement_locations, std::mt19937* rng) const {
+    // Take random movement till it's inside of the patrol range
+    int checks_done = 0;
+    while (true) {
+        checks_done++;
+        // After 20 checks, there is probably not a movement available, return starting location
+        if (checks_done > 20) {
+            return unit_loc;
+        }
+
+        const coordinates<size_t>& chosen_movement = movement_locations[random_index(movement_locations.size(), rng)];
+
+        // Return if it's in the range
+        if (is_in_units_patrol_range(chosen_movement, unit.get_id()))
+            return chosen_movement;
+    }
+}
+
+uint32_t EnemyAI::unit_seed(int unit_id) const {
+    // splitmix64 of the planning seed, the turn and the unit, so units with consecutive ids don't get similar seeds
+    uint64_t seed = planning_seed_ ^ (uint64_t(planned_turns_) << 32) ^ uint32_t(unit_id);
+    seed += 0x9e3779b97f4a7c15;
+    seed = (seed ^ (seed >> 30)) * 0xbf58476d1ce4e5b9;
+    seed = (seed ^ (seed >> 27)) * 0x94d049bb133111eb;
+    return uint32_t(seed ^ (seed >> 31));
+}
+
+size_t EnemyAI::random_index(size_t size, std::mt19937* rng) {
+    return (rng != nullptr) ? (*rng)() % size : rand() % size;
+}
+
+bool EnemyAI::should_retreat(const Unit& unit) const {
+    return unit.get_hp() <= unit_consts.max_hp * heal_self_hp_percent_threshold_ && !unit.has_healing_item();
+}
+
+coordinates<size_t> EnemyAI::best_step(const Unit& unit, const coordinates<size_t>& unit_loc, const std::vector<coordinates<size_t>>& movement_locations) const {
+    coordinates<size_t> best = unit_loc;
+
+    // A unit that can't heal itself moves to the safest tile it can reach
+    if (should_retreat(unit)) {
+        for (const coordinates<size_t>& option : movement_locations) {
+            if (influence_.danger(option) < influence_.danger(best)) best = option;
+        }
+        return best;
+    }
+
+    // Otherwise the step closest to the enemies, the safest of equally close steps
+    for (const coordinates<size_t>& option : movement_locations) {
+        const uint32_t distance = enemy_field_.distance(option);
+        const uint32_t best_distance = enemy_field_.distance(best);
+        if (distance < best_distance || (distance == best_distance && best != unit_loc && influence_.danger(option) < influence_.danger(best))) {
+            best = option;
+        }
+    }
+    return best;
+}
+
+bool EnemyAI::is_teammate(const Unit& unit) const {
+    if (unit.get_handle().valid()) return unit.get_handle().team_id == team_.get_id();
+    return game_.get_unit_team_id(unit.get_id()) == team_.get_id();
+}
+
+void EnemyAI::update_influence_map() {
+    influence_.update(map_, game_.get_teams(), team_.get_id());
+}
+
+void EnemyAI::build_enemy_field() {
+    update_influence_map();
+    initialize_patrol_ranges();
+
+    std::vector<coordinates<size_t>> visible_enemy_coords;
+    for (Unit* unit : team_.get_alive_units()) {
+        std::vector<coordinates<size_t>> unit_coords = map_.units_in_sight<LosPolicy::SeeThrough>(map_.get_unit_location(unit), unit_consts.visual_range);
+        get_visible_unit_coords(unit_coords, &visible_enemy_coords, nullptr);
+    }
+
+    // Units often see the same enemies
+    std::sort(visible_enemy_coords.begin(), visible_enemy_coords.end());
+    visible_enemy_coords.erase(std::unique(visible_enemy_coords.begin(), visible_enemy_coords.end()), visible_enemy_coords.end());
+
+    enemy_field_.build(map_, visible_enemy_coords);
+}
+
 coordinates<size_t> EnemyAI::get_lowest_hp_unit_coords(const std::vector<coordinates<size_t>> &all_coords) const {
     int current_min = unit_consts.max_hp + 1;
     const coordinates<size_t>* min_coords_ptr = nullptr;
@@ -105,13 +177,12 @@ coordinates<size_t> EnemyAI::get_lowest_hp_unit_coords(const std::vector<coordin
 
 
 void EnemyAI::get_visible_unit_coords(const std::vector<coordinates<size_t>> &vision_coords, std::vector<coordinates<size_t>> *enemy_coords, std::vector<coordinates<size_t>> *teammate_coords) {
-    int this_team_id = team_.get_id();
     for (const auto& coords : vision_coords) {
         // Check for unit at visible coords, only take alive units
         if (Unit* target_unit = map_.get_unit(coords);
             target_unit != nullptr && !target_unit->is_dead()) {
             // if seen unit is on same team
-            if (game_.get_unit_team_id(target_unit->get_id()) == this_team_id) {
+            if (is_teammate(*target_unit)) {
                 if (teammate_coords == nullptr) continue;
                 teammate_coords->push_back(coords);
             } else { // if on enemy team
@@ -123,7 +194,7 @@ void EnemyAI::get_visible_unit_coords(const std::vector<coordinates<size_t>> &vi
 
 }
 
-std::shared_ptr<Action> EnemyAI::generate_heal_action(Unit& unit, const coordinates<size_t>& unit_loc, const coordinates<size_t>& target) {
+std::shared_ptr<Action> EnemyAI::generate_heal_action(Unit& unit, const coordinates<size_t>& unit_loc, const coordinates<size_t>& target, std::mt19937* rng) {
     // Use building if possible
     if (map_.has_healing_building(unit_loc)) {
         return map_.get_building(unit_loc)->use_building(target, unit);
@@ -131,7 +202,7 @@ std::shared_ptr<Action> EnemyAI::generate_heal_action(Unit& unit, const coordina
 
     if (unit.has_healing_item()) {
         std::vector<std::shared_ptr<const HealingItem>> heal_items = unit.get_healing_items();
-        return heal_items[rand() % heal_items.size()]->get_action(target, unit);
+        return heal_items[random_index(heal_items.size(), rng)]->get_action(target, unit);
     }
 
     // If no healing item to use, return nullptr
@@ -139,7 +210,7 @@ std::shared_ptr<Action> EnemyAI::generate_heal_action(Unit& unit, const coordina
 }
 
 
-std::shared_ptr<Action> EnemyAI::generate_weapon_action(Unit &unit, const coordinates<size_t>& unit_loc, const coordinates<size_t> &target) {
+std::shared_ptr<Action> EnemyAI::generate_weapon_action(Unit &unit, const coordinates<size_t>& unit_loc, const coordinates<size_t> &target, std::mt19937* rng) {
     // Use building is possible
     if (map_.has_weapon_building(unit_loc)) {
         return map_.get_building(unit_loc)->use_building(target, unit);
@@ -147,13 +218,13 @@ std::shared_ptr<Action> EnemyAI::generate_weapon_action(Unit &unit, const coordi
 
     if (unit.has_weapon()) {
         std::vector<std::shared_ptr<const Weapon>> weapons = unit.get_weapons();
-        return weapons[rand() % weapons.size()]->get_action(target, unit);
+        return weapons[random_index(weapons.size(), rng)]->get_action(target, unit);
     }
 
     return nullptr;
 }
 
-std::shared_ptr<Action> EnemyAI::generate_building_part_action(Unit& unit, const std::vector<coordinates<size_t>>& visible_coords) {
+std::shared_ptr<Action> EnemyAI::generate_building_part_action(Unit& unit, const std::vector<coordinates<size_t>>& visible_coords, std::mt19937* rng) {
     // If unit doesn't have a building part, this action is impossible
     std::vector<std::shared_ptr<const BuildingPart>> building_parts = unit.get_building_parts();
     if (building_parts.empty()) return nullptr;
@@ -184,30 +255,30 @@ std::shared_ptr<Action> EnemyAI::generate_building_part_action(Unit& unit, const
         return nullptr;
 
     //If there were no buildings to add a part to, just add it to an empty place
-    coordinates<size_t> target = *coords_to_build_on[rand() % coords_to_build_on.size()];
-    return building_parts[rand() % building_parts.size()]->get_action(std::move(target), unit);
+    coordinates<size_t> target = *coords_to_build_on[random_index(coords_to_build_on.size(), rng)];
+    return building_parts[random_index(building_parts.size(), rng)]->get_action(std::move(target), unit);
 
 }
 
-std::shared_ptr<Action> EnemyAI::generate_action(Unit& unit, const coordinates<size_t>& unit_loc) {
+std::shared_ptr<Action> EnemyAI::generate_action(Unit& unit, const coordinates<size_t>& unit_loc, std::mt19937* rng) {
     if (unit.is_dead()) return nullptr;
 
     // If unit is low and has a way to heal itself, heal self
     if (unit.get_hp() <= unit_consts.max_hp * heal_self_hp_percent_threshold_) {
         // Generate heal action and return it if it's not nullptr
-        if (std::shared_ptr<Action> heal_action = generate_heal_action(unit, unit_loc, unit_loc);
+        if (std::shared_ptr<Action> heal_action = generate_heal_action(unit, unit_loc, unit_loc, rng);
             heal_action != nullptr) {
             return heal_action;
         }
     }
 
 
-    // Get coordinates that have a teammate or enemy on them
-    std::vector<coordinates<size_t>> vision_coords = map_.tiles_unit_sees(unit_loc, unit_consts.visual_range);
+    // Get coordinates that have a teammate or enemy on them, only the occupied tiles in range are checked for line of sight
+    std::vector<coordinates<size_t>> unit_coords = map_.units_in_sight<LosPolicy::SeeThrough>(unit_loc, unit_consts.visual_range);
     std::vector<coordinates<size_t>> visible_enemy_coords;
     std::vector<coordinates<size_t>> visible_teammate_coords;
 
-    get_visible_unit_coords(vision_coords, &visible_enemy_coords, &visible_teammate_coords);
+    get_visible_unit_coords(unit_coords, &visible_enemy_coords, &visible_teammate_coords);
 
     // Prioritize attacking enemies. kills > teamplay
     if (!visible_enemy_coords.empty()) {
@@ -215,7 +286,7 @@ std::shared_ptr<Action> EnemyAI::generate_action(Unit& unit, const coordinates<s
         coordinates<size_t> target_coords = get_lowest_hp_unit_coords(visible_enemy_coords);
 
         // If weapon_action was possible (AKA has something to attack with), return that action. otherwise keep going
-        std::shared_ptr<Action> weapon_action = generate_weapon_action(unit, unit_loc, target_coords);
+        std::shared_ptr<Action> weapon_action = generate_weapon_action(unit, unit_loc, target_coords, rng);
         if (weapon_action != nullptr) {
             return weapon_action;
         }
@@ -226,7 +297,7 @@ std::shared_ptr<Action> EnemyAI::generate_action(Unit& unit, const coordinates<s
         coordinates<size_t> target_coords = get_lowest_hp_unit_coords(visible_teammate_coords);
         if (Unit* target_unit = map_.get_unit(target_coords);
             target_unit != nullptr && target_unit->get_hp() < unit_consts.max_hp * heal_others_hp_percent_threshold_) {
-            if (std::shared_ptr<Action> heal_action = generate_heal_action(unit, unit_loc, target_coords);
+            if (std::shared_ptr<Action> heal_action = generate_heal_action(unit, unit_loc, target_coords, rng);
                 heal_action != nullptr) {
                 return heal_action;
             }
@@ -234,7 +305,8 @@ std::shared_ptr<Action> EnemyAI::generate_action(Unit& unit, const coordinates<s
     }
 
     // If can't heal teammates, place any building parts anywhere, prioritizing already staretd buildings
-    if (std::shared_ptr<Action> building_part_action = generate_building_part_action(unit, vision_coords);
+    std::vector<coordinates<size_t>> vision_coords = map_.tiles_unit_sees(unit_loc, unit_consts.visual_range);
+    if (std::shared_ptr<Action> building_part_action = generate_building_part_action(unit, vision_coords, rng);
         building_part_action != nullptr) {
         return building_part_action;
     }
@@ -244,7 +316,7 @@ std::shared_ptr<Action> EnemyAI::generate_action(Unit& unit, const coordinates<s
 }
 
 void EnemyAI::generate_turn(Unit &unit) {
-    coordinates<size_t> unit_location = game_.get_unit_location(unit.get_id());
+    coordinates<size_t> unit_location = map_.get_unit_location(&unit);
     coordinates<size_t> movement_target = generate_movement(unit, unit_location);
 
     // First generate and queue the movement action, so that the unit moves before executing the other action
@@ -258,12 +330,117 @@ void EnemyAI::generate_turn(Unit &unit) {
 
 
 void EnemyAI::generate_whole_teams_turns() {
+    if (planning_jobs_ != 1) {
+        if (planning_pool_ == nullptr) planning_pool_ = std::make_shared<ThreadPool>(planning_jobs_);
+        generate_whole_teams_turns_parallel(*planning_pool_);
+        return;
+    }
+
+    // One search for the whole team, every unit then picks its movement from the field
+    build_enemy_field();
     for (Unit& unit : team_.get_units()) {
         if (unit.is_dead()) continue;
         generate_turn(unit);
     }
 }
 
+void EnemyAI::set_planning_jobs(size_t jobs) {
+    planning_jobs_ = jobs;
+    planning_pool_.reset();
+}
+
+void EnemyAI::set_planning_seed(uint64_t seed) {
+    planning_seed_ = seed;
+    planned_turns_ = 0;
+}
+
+void EnemyAI::plan_movement(UnitPlan& plan) const {
+    std::vector<coordinates<size_t>> movement_locations = map_.possible_tiles_to_move_to3(plan.location, unit_consts.move_range);
+    if (movement_locations.empty()) return;
+
+    if (enemy_field_.empty() || enemy_field_.distance(plan.location) == FlowField::unreachable) {
+        if (is_in_units_patrol_range(plan.location, plan.unit->get_id())) {
+            plan.movement_options.push_back(random_patrol_movement(*plan.unit, plan.location, movement_locations, &plan.rng));
+        } else {
+            // The searches were prepared before the threads started
+            const PatrolRange& range = patrol_ranges_.at(plan.unit->get_id());
+            plan.movement_options.push_back(map_.fastest_movement_to_target(plan.location, range.center, unit_consts.move_range));
+        }
+        return;
+    }
+
+    if (should_retreat(*plan.unit)) {
+        // The tiles safer than staying, safest first
+        const int32_t current_danger = influence_.danger(plan.location);
+        for (const coordinates<size_t>& option : movement_locations) {
+            if (influence_.danger(option) < current_danger) plan.movement_options.push_back(option);
+        }
+        std::stable_sort(plan.movement_options.begin(), plan.movement_options.end(), [this](const auto& a, const auto& b) {
+            return influence_.danger(a) < influence_.danger(b);
+        });
+    } else {
+        // The steps towards the enemies, best first like best_step: the closest, then the safest. Ties keep the order of movement_locations
+        const uint32_t current_distance = enemy_field_.distance(plan.location);
+        for (const coordinates<size_t>& option : movement_locations) {
+            if (enemy_field_.distance(option) < current_distance) plan.movement_options.push_back(option);
+        }
+        std::stable_sort(plan.movement_options.begin(), plan.movement_options.end(), [this](const auto& a, const auto& b) {
+            const uint32_t distance_a = enemy_field_.distance(a);
+            const uint32_t distance_b = enemy_field_.distance(b);
+            return distance_a != distance_b ? distance_a < distance_b : influence_.danger(a) < influence_.danger(b);
+        });
+    }
+    if (plan.movement_options.size() > max_movement_options) plan.movement_options.resize(max_movement_options);
+}
+
+void EnemyAI::generate_whole_teams_turns_parallel(ThreadPool& pool) {
+    build_enemy_field();
+    // What the searches would build on first use is built here, the threads only read the map
+    game_.get_map().prepare_searches();
+    planned_turns_++;
+
+    std::vector<UnitPlan> plans;
+    SlotMap<Unit>& units = team_.get_units();
+    plans.reserve(units.size());
+    for (Unit& unit : units) {
+        if (unit.is_dead()) continue;
+        UnitPlan& plan = plans.emplace_back();
+        plan.unit = &unit;
+        plan.location = map_.get_unit_location(plan.unit);
+        // Every unit has its own random numbers, so the plans don't depend on which thread makes them
+        plan.rng.seed(unit_seed(unit.get_id()));
+    }
+
+    // The map doesn't change until all the movements are planned
+    pool.parallel_for(plans.size(), [&](size_t index, size_t) { plan_movement(plans[index]); });
+
+    // Merge in the order of the units: every unit takes its best movement that no unit before it has taken,
+    // and the movements are executed right away so the map is up to date for the actions
+    std::unordered_set<size_t> taken_tiles;
+    for (UnitPlan& plan : plans) {
+        coordinates<size_t> target = plan.location;
+        for (const coordinates<size_t>& option : plan.movement_options) {
+            if (taken_tiles.count(option.y * map_.width() + option.x) == 0 && (option == plan.location || map_.can_move_to_coords(option.y, option.x))) {
+                target = option;
+                break;
+            }
+        }
+        taken_tiles.insert(target.y * map_.width() + target.x);
+        plan.location_after_movement = target;
+        game_.add_action(std::make_shared<MovementAction>(plan.location, target, *plan.unit), team_.get_id());
+    }
+
+    // The actions are planned against the map after all the movements, which again doesn't change until they're all planned
+    pool.parallel_for(plans.size(), [&](size_t index, size_t) {
+        UnitPlan& plan = plans[index];
+        plan.action = generate_action(*plan.unit, plan.location_after_movement, &plan.rng);
+    });
+    for (UnitPlan& plan : plans) {
+        if (plan.action == nullptr) continue;
+        game_.add_action(std::move(plan.action), team_.get_id());
+    }
+}
+
 int EnemyAI::team_id() const {
     return team_.get_id();
 }
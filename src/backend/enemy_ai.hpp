@@ -5,10 +5,15 @@
 #include <unordered_map>
 #include <array>
 #include <cmath>
+#include <random>
+#include <cstdint>
 
 #include "coordinates.hpp"
 #include "map.hpp"
 #include "helper_tools.hpp"
+#include "flow_field.hpp"
+#include "influence_map.hpp"
+#include "ai_controller.hpp"
 
 class Game;
 class Team;
@@ -16,7 +21,7 @@ class Turn;
 class Unit;
 class Action;
 
-class EnemyAI {
+class EnemyAI : public AIController {
 public:
     /**
      * @brief constructor for the EnemyAI class
@@ -27,7 +32,9 @@ public:
     EnemyAI(Game& game, Team& team);
 
     /**
-     * @brief initializes patrol ranges of all units to be centered on their current location, called in constructor
+     * @brief Centers the patrol ranges of the units that don't have one yet on their current location, and drops the ranges
+     * of the units that are no longer in the team. Called in the constructor and by build_enemy_field at the start of every
+     * turn, so units added to the team during the game get a patrol range where they were added.
      *
      * @return void
      */
@@ -40,16 +47,47 @@ public:
      * @param unit_id
      * @return bool
      */
-    bool is_in_units_patrol_range(const coordinates<size_t>& coords, int unit_id);
+    bool is_in_units_patrol_range(const coordinates<size_t>& coords, int unit_id) const;
 
     /**
-     * @brief Generates coordinates for the given unit to move to
+     * @brief Generates coordinates for the given unit to move to. If the team can see enemies, moves towards the closest one
+     * using the enemy field (see best_step), otherwise patrols.
      *
      * @param unit the unit that we want to generate movement for
      * @return coordinates<size_t>
      */
     coordinates<size_t> generate_movement(Unit& unit, const coordinates<size_t>& unit_loc);
 
+    /**
+     * @brief Picks the movement of a unit that can reach an enemy. A unit that is low on HP and can't heal itself moves to the
+     * tile with the lowest danger in the influence map. Others take the step closest to the enemies, and of equally close
+     * steps the one with the lowest danger.
+     *
+     * @param movement_locations the tiles the unit can move to
+     * @return coordinates<size_t> the chosen tile, <unit_loc> if no option is better than staying
+     */
+    coordinates<size_t> best_step(const Unit& unit, const coordinates<size_t>& unit_loc, const std::vector<coordinates<size_t>>& movement_locations) const;
+
+    /**
+     * @brief Brings the influence map up to date with the units of the game, called by build_enemy_field
+     */
+    void update_influence_map();
+
+    /**
+     * @brief The threat and support grids of the team and the teams of the units, as of the start of the turn
+     */
+    inline const InfluenceMap& influence_map() const {
+        return influence_;
+    }
+
+    /**
+     * @brief Builds the distance field to every enemy that the team can see, used by generate_movement.
+     * Called once at the start of the team's turn, updates the influence map and the patrol ranges first.
+     *
+     * @return void
+     */
+    void build_enemy_field();
+
     /**
      * @brief Returns the coordinates that have the lowest HP unit on them. Causes an exception if the coordinates don't have any units at all.
      *
@@ -84,7 +122,7 @@ public:
      * @param target location that the action is targeted on
      * @return std::shared_ptr<Action> shared_ptr to the healing action, nullptr if there is not healing item to use
      */
-    std::shared_ptr<Action> generate_heal_action(Unit& unit, const coordinates<size_t>& unit_loc, const coordinates<size_t>& target);
+    std::shared_ptr<Action> generate_heal_action(Unit& unit, const coordinates<size_t>& unit_loc, const coordinates<size_t>& target, std::mt19937* rng = nullptr);
 
     /**
      * @brief generate a weapon action for the specified unit, targeting specified location. returns nullptr if the unit has no weapons to use
@@ -94,7 +132,7 @@ public:
      * @param target targeted coordinates
      * @return std::shared_ptr<Action> the action to be executed, nullptr if no weapon to use
      */
-    std::shared_ptr<Action> generate_weapon_action(Unit& unit, const coordinates<size_t>& unit_loc, const coordinates<size_t>& target);
+    std::shared_ptr<Action> generate_weapon_action(Unit& unit, const coordinates<size_t>& unit_loc, const coordinates<size_t>& target, std::mt19937* rng = nullptr);
 
     /**
      * @brief generates an action for using a building part
@@ -103,15 +141,16 @@ public:
      * @param visible_coords coords that the unit can see
      * @return std::shared_ptr<Action> ptr to the action. nullptr if cannot perform a building part action (ie. doesn't have right item)
      */
-    std::shared_ptr<Action> generate_building_part_action(Unit& unit, const std::vector<coordinates<size_t>>& visible_coords);
+    std::shared_ptr<Action> generate_building_part_action(Unit& unit, const std::vector<coordinates<size_t>>& visible_coords, std::mt19937* rng = nullptr);
 
     /**
      * @brief Generate action for the unit to do
      *
      * @param unit unit which the action is generated for
+     * @param rng the random numbers for the random choices, nullptr uses rand(). The generate_*_action functions take it too
      * @return std::shared_ptr<Action>
      */
-    std::shared_ptr<Action> generate_action(Unit& unit, const coordinates<size_t>& unit_loc);
+    std::shared_ptr<Action> generate_action(Unit& unit, const coordinates<size_t>& unit_loc, std::mt19937* rng = nullptr);
 
     /**
      * @brief Generates a turn (movement and action) for the specified unit and adds it to the team's action queue
@@ -126,13 +165,35 @@ public:
      *
      * @return void
      */
-    void generate_whole_teams_turns();
+    void generate_whole_teams_turns() override;
+
+    /**
+     * @brief Sets how the team's turns are planned. With 1 job (the default) the units plan one after another and every unit
+     * sees what the units before it did. With more jobs, or 0 for the amount of hardware threads, generate_whole_teams_turns
+     * plans on a thread pool with generate_whole_teams_turns_parallel.
+     */
+    void set_planning_jobs(size_t jobs) override;
 
-    int team_id() const;
+    /**
+     * @brief Seed for the random choices of the parallel planning. With the same seed the turns are the same with any amount of jobs.
+     */
+    void set_planning_seed(uint64_t seed) override;
+
+    /**
+     * @brief Plans the turns of all the units at once on <pool>. The searches are prepared first (see Map::prepare_searches),
+     * then the units plan their movements on the threads only reading the map, which doesn't change until all of them
+     * are done. Every unit has its own random numbers seeded from its id. The movements are then merged in the order of the units:
+     * every unit takes the best of its movements that no unit before it took, or stays. After the movements are executed
+     * the actions are planned the same way against the map after the movements and queued in the order of the units.
+     */
+    void generate_whole_teams_turns_parallel(ThreadPool& pool);
+
+    int team_id() const override;
 
 private:
     Game& game_;
-    Map& map_;
+    // The AI only reads the map, the turns are changed through the game
+    const Map& map_;
     Team& team_;
 
 
@@ -168,6 +229,48 @@ private:
 
     std::unordered_map<int, PatrolRange> patrol_ranges_;
 
+    // distances to the enemies the team could see at the start of the turn
+    FlowField enemy_field_;
+
+    // threat and healing support of the tiles at the start of the turn
+    InfluenceMap influence_;
+
+    // true if the unit is low on HP and can't heal itself, so it moves away from the enemies instead of towards them
+    bool should_retreat(const Unit& unit) const;
+
+    // the team is read from the handle of the unit, units that aren't in a team are looked up from the game
+    bool is_teammate(const Unit& unit) const;
+
+    // The turn of a unit planned by generate_whole_teams_turns_parallel
+    struct UnitPlan {
+        Unit* unit;
+        coordinates<size_t> location;
+        // movements in order of preference, the unit stays if all of them are taken
+        std::vector<coordinates<size_t>> movement_options;
+        coordinates<size_t> location_after_movement;
+        std::mt19937 rng;
+        std::shared_ptr<Action> action;
+    };
+
+    size_t planning_jobs_ = 1;
+    std::shared_ptr<ThreadPool> planning_pool_;
+    uint64_t planning_seed_ = 0;
+    // the amount of turns planned in parallel since the seed was set, mixed into the seeds of the units
+    uint64_t planned_turns_ = 0;
+
+    // Fills the movement options of <plan>, only reads the map so it can be called from several threads
+    void plan_movement(UnitPlan& plan) const;
+
+    coordinates<size_t> random_patrol_movement(Unit& unit, const coordinates<size_t>& unit_loc, const std::vector<coordinates<size_t>>& movement_locations, std::mt19937* rng) const;
+
+    // the seed of the random numbers of the unit with <unit_id> for the current turn, the same wherever the unit is in the team
+    uint32_t unit_seed(int unit_id) const;
+
+    // a random index below <size> from <rng>, or from rand() if it's nullptr
+    static size_t random_index(size_t size, std::mt19937* rng);
+
+    static inline size_t max_movement_options = 8;
+
     static inline size_t patrol_range_side_length = 6;
     static inline float heal_self_hp_percent_threshold_ = 0.5;
     static inline float heal_others_hp_percent_threshold_ = 0.3;
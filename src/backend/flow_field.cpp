@@ -0,0 +1,58 @@
+#include <queue>
+#include <functional>
+
+#include "flow_field.hpp"
+#include "map.hpp"
+
+
+void FlowField::build( const Map& map, const std::vector< coordinates<size_t> >& targets ) {
+    using Entry = std::pair<uint32_t, uint32_t>;
+
+    width_ = map.width();
+    targets_ = targets.size();
+    distance_.assign( map.width() * map.height(), unreachable );
+
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue;
+    for ( const coordinates<size_t>& target : targets ) {
+        const uint32_t idx = target.y * width_ + target.x;
+        distance_[idx] = 0;
+        queue.emplace( 0, idx );
+    }
+
+    // The search goes backwards from the targets, so the cost of a step is the movement cost of the tile
+    // being left, which is the tile stepped on when walking towards the target
+    while ( !queue.empty() ) {
+        auto [distance, idx] = queue.top();
+        queue.pop();
+        if ( distance != distance_[idx] ) continue;
+
+        const size_t y = idx / width_;
+        const size_t x = idx % width_;
+        const uint32_t new_distance = distance + map.movement_cost( y, x );
+
+        auto relax = [&]( size_t n_y, size_t n_x ) {
+            if ( !map.can_move_to_terrain( n_y, n_x ) ) return;
+
+            const uint32_t neighbour_idx = n_y * width_ + n_x;
+            if ( new_distance < distance_[neighbour_idx] ) {
+                distance_[neighbour_idx] = new_distance;
+                queue.emplace( new_distance, neighbour_idx );
+            }
+        };
+
+        if ( y > 0 ) relax( y - 1, x );
+        if ( x + 1 < map.width() ) relax( y, x + 1 );
+        if ( y + 1 < map.height() ) relax( y + 1, x );
+        if ( x > 0 ) relax( y, x - 1 );
+    }
+}
+
+
+uint32_t FlowField::distance( size_t y, size_t x ) const {
+    return distance_[ y * width_ + x ];
+}
+
+
+uint32_t FlowField::distance( const coordinates<size_t>& coords ) const {
+    return distance( coords.y, coords.x );
+}
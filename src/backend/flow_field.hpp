@@ -0,0 +1,54 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <limits>
+
+#include "coordinates.hpp"
+
+class Map;
+
+
+/**
+ * @brief Distance field from a set of target tiles. Every tile stores the cost of the cheapest path from it
+ * to the closest target, so any number of units can pick their step towards the targets by looking at the
+ * tiles they can move to, instead of each searching for a path of their own.
+ *
+ * Only the terrain is taken into account, like HierarchicalPathfinder. The tiles a unit can actually move to
+ * already avoid the other units.
+ */
+class FlowField
+{
+    public:
+        static constexpr uint32_t unreachable = std::numeric_limits<uint32_t>::max();
+
+        FlowField() = default;
+
+        /**
+         * @brief Calculates the distances with a multi-source Dijkstra from <targets>. The targets themselves get distance 0.
+         *
+         * @param map the map the field is calculated on
+         * @param targets the tiles to move towards
+         */
+        void build( const Map& map, const std::vector< coordinates<size_t> >& targets );
+
+        /**
+         * @brief The cost of the cheapest path from the tile to the closest target, FlowField::unreachable if there's no path
+         */
+        [[nodiscard]]
+        uint32_t distance( size_t y, size_t x ) const;
+        [[nodiscard]]
+        uint32_t distance( const coordinates<size_t>& coords ) const;
+
+        [[nodiscard]]
+        inline bool empty() const noexcept
+        {
+            return targets_ == 0;
+        }
+
+    private:
+        size_t width_ = 0;
+        size_t targets_ = 0;
+        std::vector<uint32_t> distance_;
+};
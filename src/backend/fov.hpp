@@ -0,0 +1,226 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#include "coordinates.hpp"
+#include "range_tables.hpp"
+
+
+/*
+ * Field of view with symmetric shadowcasting (https://www.albertford.com/shadowcasting/).
+ * The area around the origin is split into 4 quadrants (north, east, south and west) that are scanned
+ * row by row moving away from the origin. Every row only covers the columns between the start and end
+ * slope, and blocking tiles narrow the slopes for the rows after them, so every tile is looked at once.
+ *
+ * A tile that doesn't block is visible when its center is inside the slopes, which makes the result
+ * symmetric: if A sees B, B sees A. Blocking tiles are visible when any part of them is, so walls
+ * get drawn. Tiles outside of the map block and aren't revealed.
+ */
+namespace Fov
+{
+
+// A slope as the fraction <numerator> / <denominator>, the denominator is always positive
+struct Slope
+{
+    int64_t numerator;
+    int64_t denominator;
+};
+
+// floor( a / b ) for a positive b, integer division rounds towards 0 instead
+constexpr inline int64_t floor_div( int64_t a, int64_t b ) noexcept
+{
+    return a >= 0 ? a / b : -( ( -a + b - 1 ) / b );
+}
+
+// The first column of a row: depth * slope rounded to the closest integer, ties rounded up
+constexpr inline int64_t first_column( int64_t depth, const Slope& slope ) noexcept
+{
+    return floor_div( 2 * depth * slope.numerator + slope.denominator, 2 * slope.denominator );
+}
+
+// The last column of a row: depth * slope rounded to the closest integer, ties rounded down
+constexpr inline int64_t last_column( int64_t depth, const Slope& slope ) noexcept
+{
+    return -floor_div( -2 * depth * slope.numerator + slope.denominator, 2 * slope.denominator );
+}
+
+// The slope to the edge of the tile that is closer to the start of the row
+constexpr inline Slope tile_slope( int64_t depth, int64_t column ) noexcept
+{
+    return { 2 * column - 1, 2 * depth };
+}
+
+// If the center of the tile is between the slopes
+constexpr inline bool is_symmetric( int64_t depth, int64_t column, const Slope& start, const Slope& end ) noexcept
+{
+    return column * start.denominator >= depth * start.numerator && column * end.denominator <= depth * end.numerator;
+}
+
+/*
+ * Scans the rows of one quadrant starting from <depth> between the slopes.
+ * <to_map> turns the (depth, column) of the quadrant into map coordinates (x, y), returning false if they're outside of the map.
+ */
+template<typename ToMap, typename IsBlocking, typename Reveal>
+void scan( int64_t depth, Slope start, Slope end, int64_t range, const ToMap& to_map, IsBlocking& is_blocking, Reveal& reveal )
+{
+    // Rows further than <range> can't have any tiles inside of the radius
+    while ( depth <= range ) {
+        const int64_t min_column = first_column( depth, start );
+        const int64_t max_column = last_column( depth, end );
+        // the columns of the row that are inside of the radius
+        const int64_t half_width = RangeTables::disc_half_width( range, depth );
+        // -1 before the first tile, then 1 if the previous tile blocked and 0 if it didn't
+        int previous_blocked = -1;
+
+        for ( int64_t column = min_column; column <= max_column; column++ ) {
+            int64_t x, y;
+            const bool inside = to_map( depth, column, x, y );
+            const bool blocked = !inside || is_blocking( y, x );
+
+            if ( inside && ( blocked || is_symmetric( depth, column, start, end ) ) && column >= -half_width && column <= half_width ) {
+                reveal( y, x );
+            }
+
+            if ( previous_blocked == 1 && !blocked ) {
+                start = tile_slope( depth, column );
+            }
+            if ( previous_blocked == 0 && blocked ) {
+                // The part of the row before this tile continues on its own
+                scan( depth + 1, start, tile_slope( depth, column ), range, to_map, is_blocking, reveal );
+            }
+            previous_blocked = blocked;
+        }
+
+        // If the row ended with a blocking tile (or was empty) there's nothing left to see behind it
+        if ( previous_blocked != 0 ) return;
+        depth++;
+    }
+}
+
+/**
+ * @brief Calls <reveal>(y, x) for every tile visible from <origin> within <range>. A tile can be revealed more than once.
+ *
+ * @param origin where the view is from, always revealed
+ * @param range the radius of the view, tiles with dx^2 + dy^2 <= range^2 + range are inside of it
+ * @param width the width of the map
+ * @param height the height of the map
+ * @param is_blocking callable (y, x) -> bool, true if the tile blocks the view
+ * @param reveal callable (y, x) called for the visible tiles
+ */
+template<typename IsBlocking, typename Reveal>
+void shadowcast( const coordinates<size_t>& origin, uint32_t range, size_t width, size_t height, IsBlocking&& is_blocking, Reveal&& reveal )
+{
+    const int64_t origin_x = origin.x;
+    const int64_t origin_y = origin.y;
+    const int64_t map_width = width;
+    const int64_t map_height = height;
+
+    reveal( origin.y, origin.x );
+
+    auto make_quadrant = [&]( int64_t depth_x, int64_t depth_y, int64_t column_x, int64_t column_y ) {
+        return [=]( int64_t depth, int64_t column, int64_t& x, int64_t& y ) {
+            x = origin_x + depth * depth_x + column * column_x;
+            y = origin_y + depth * depth_y + column * column_y;
+            return x >= 0 && y >= 0 && x < map_width && y < map_height;
+        };
+    };
+
+    const Slope start = { -1, 1 };
+    const Slope end = { 1, 1 };
+    scan( 1, start, end, range, make_quadrant( 0, -1, 1, 0 ), is_blocking, reveal );  // north
+    scan( 1, start, end, range, make_quadrant( 1, 0, 0, 1 ), is_blocking, reveal );   // east
+    scan( 1, start, end, range, make_quadrant( 0, 1, 1, 0 ), is_blocking, reveal );   // south
+    scan( 1, start, end, range, make_quadrant( -1, 0, 0, 1 ), is_blocking, reveal );  // west
+}
+
+/*
+ * Like scan, but only answers if the tile at (<target_depth>, <target_column>) of the quadrant gets revealed, returning as soon as it's known.
+ * The rows of the last depth aren't scanned further than the target.
+ */
+template<typename ToMap, typename IsBlocking>
+bool scan_to( int64_t depth, Slope start, Slope end, int64_t target_depth, int64_t target_column, const ToMap& to_map, IsBlocking& is_blocking )
+{
+    while ( depth < target_depth ) {
+        const int64_t min_column = first_column( depth, start );
+        const int64_t max_column = last_column( depth, end );
+        int previous_blocked = -1;
+
+        for ( int64_t column = min_column; column <= max_column; column++ ) {
+            int64_t x, y;
+            const bool blocked = !to_map( depth, column, x, y ) || is_blocking( y, x );
+
+            if ( previous_blocked == 1 && !blocked ) {
+                start = tile_slope( depth, column );
+            }
+            if ( previous_blocked == 0 && blocked ) {
+                if ( scan_to( depth + 1, start, tile_slope( depth, column ), target_depth, target_column, to_map, is_blocking ) ) return true;
+            }
+            previous_blocked = blocked;
+        }
+
+        if ( previous_blocked != 0 ) return false;
+        depth++;
+    }
+
+    if ( target_column < first_column( depth, start ) || target_column > last_column( depth, end ) ) return false;
+
+    int64_t x, y;
+    to_map( depth, target_column, x, y );
+    return is_blocking( y, x ) || is_symmetric( depth, target_column, start, end );
+}
+
+/**
+ * @brief Checks if shadowcast from <origin> would reveal <target>, without going through the whole view.
+ *
+ * Only the cone from <origin> through the target tile is scanned: every sector of the full scan that reaches the target
+ * overlaps the target tile, and cutting the sectors to the slopes of the target tile doesn't change if it's revealed.
+ * The result is the same as looking for <target> in the tiles shadowcast reveals.
+ *
+ * @param range the radius of the view like in shadowcast, targets outside of it are rejected right away
+ * @param is_blocking callable (y, x) -> bool, true if the tile blocks the view
+ */
+template<typename IsBlocking>
+bool is_visible( const coordinates<size_t>& origin, const coordinates<size_t>& target, uint32_t range, size_t width, size_t height, IsBlocking&& is_blocking )
+{
+    const int64_t dx = int64_t( target.x ) - int64_t( origin.x );
+    const int64_t dy = int64_t( target.y ) - int64_t( origin.y );
+
+    const int64_t half_width = RangeTables::disc_half_width( range, dy );
+    if ( dx < -half_width || dx > half_width || target.x >= width || target.y >= height ) return false;
+    if ( dx == 0 && dy == 0 ) return true;
+
+    const int64_t origin_x = origin.x;
+    const int64_t origin_y = origin.y;
+    const int64_t map_width = width;
+    const int64_t map_height = height;
+
+    auto check_quadrant = [&]( int64_t depth_x, int64_t depth_y, int64_t column_x, int64_t column_y ) {
+        auto to_map = [=]( int64_t depth, int64_t column, int64_t& x, int64_t& y ) {
+            x = origin_x + depth * depth_x + column * column_x;
+            y = origin_y + depth * depth_y + column * column_y;
+            return x >= 0 && y >= 0 && x < map_width && y < map_height;
+        };
+
+        // depth and column of the target in this quadrant
+        const int64_t depth = dx * depth_x + dy * depth_y;
+        const int64_t column = dx * column_x + dy * column_y;
+
+        // The cone through the target tile, cut to the quadrant
+        Slope start = tile_slope( depth, column );
+        Slope end = tile_slope( depth, column + 1 );
+        if ( start.numerator < -start.denominator ) start = { -1, 1 };
+        if ( end.numerator > end.denominator ) end = { 1, 1 };
+
+        return scan_to( 1, start, end, depth, column, to_map, is_blocking );
+    };
+
+    // Targets on a diagonal are in two quadrants
+    const int64_t abs_dx = dx < 0 ? -dx : dx;
+    const int64_t abs_dy = dy < 0 ? -dy : dy;
+    if ( abs_dy >= abs_dx && check_quadrant( 0, dy < 0 ? -1 : 1, 1, 0 ) ) return true;
+    if ( abs_dx >= abs_dy && check_quadrant( dx < 0 ? -1 : 1, 0, 0, 1 ) ) return true;
+    return false;
+}
+
+} // namespace Fov
@@ -0,0 +1,81 @@
+#include "fov_cache.hpp"
+
+
+FovCache& FovCache::operator = ( const FovCache& other ) {
+    if ( this != &other ) clear();
+    return *this;
+}
+
+
+FovCache::Result FovCache::find( size_t terrain_version, const coordinates<size_t>& origin, uint32_t range, uint8_t policy ) {
+    std::lock_guard<std::mutex> lock( mutex_ );
+    if ( terrain_version != terrain_version_ ) {
+        results_.clear();
+        stored_tiles_ = 0;
+        terrain_version_ = terrain_version;
+    }
+
+    auto it = results_.find( Key{ origin.y, origin.x, range, policy } );
+    if ( it == results_.end() ) {
+        misses_++;
+        return nullptr;
+    }
+    hits_++;
+    return it->second;
+}
+
+
+void FovCache::store( size_t terrain_version, const coordinates<size_t>& origin, uint32_t range, uint8_t policy, std::vector<uint32_t> visible ) {
+    Result result = std::make_shared< const std::vector<uint32_t> >( std::move( visible ) );
+
+    std::lock_guard<std::mutex> lock( mutex_ );
+    if ( terrain_version != terrain_version_ || stored_tiles_ + result->size() > max_tiles ) {
+        results_.clear();
+        stored_tiles_ = 0;
+        terrain_version_ = terrain_version;
+    }
+    const size_t tiles = result->size();
+    auto [it, inserted] = results_.try_emplace( Key{ origin.y, origin.x, range, policy }, std::move( result ) );
+    // Another thread may have stored the same result in the meantime
+    if ( inserted ) stored_tiles_ += tiles;
+}
+
+
+void FovCache::clear() {
+    std::lock_guard<std::mutex> lock( mutex_ );
+    results_.clear();
+    stored_tiles_ = 0;
+    hits_ = 0;
+    misses_ = 0;
+}
+
+
+size_t FovCache::hits() const {
+    std::lock_guard<std::mutex> lock( mutex_ );
+    return hits_;
+}
+
+
+size_t FovCache::misses() const {
+    std::lock_guard<std::mutex> lock( mutex_ );
+    return misses_;
+}
+
+
+void FovCache::reset_counters() {
+    std::lock_guard<std::mutex> lock( mutex_ );
+    hits_ = 0;
+    misses_ = 0;
+}
+
+
+size_t FovCache::size() const {
+    std::lock_guard<std::mutex> lock( mutex_ );
+    return results_.size();
+}
+
+
+size_t FovCache::stored_tiles() const {
+    std::lock_guard<std::mutex> lock( mutex_ );
+    return stored_tiles_;
+}
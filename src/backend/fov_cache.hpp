@@ -0,0 +1,89 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+#include <mutex>
+#include <unordered_map>
+
+#include "coordinates.hpp"
+
+
+/**
+ * @brief Results of the line of sight checks of a map, keyed by the origin, range and blocking policy.
+ * The line of sight only depends on the terrain, so the results are kept until the terrain version of the map
+ * changes, after which the whole cache is cleared on the next lookup.
+ *
+ * The results are kept as the indices (y * width + x) of the tiles, and the size of the cache is limited by the
+ * amount of stored tiles rather than the amount of results, so checks with a long range can't make it grow large.
+ *
+ * Lookups and stores are guarded with a mutex so a const Map can be queried from several threads. A result is shared
+ * with the callers that found it instead of copied, so the lock is only held for the lookup itself.
+ * Copying a cache gives an empty cache, the results belong to the map they were calculated on.
+ */
+class FovCache
+{
+    public:
+        FovCache() = default;
+        FovCache( const FovCache& ) noexcept : FovCache() { }
+        FovCache& operator = ( const FovCache& );
+
+        using Result = std::shared_ptr< const std::vector<uint32_t> >;
+
+        /**
+         * @brief The cached tile indices for the terrain version
+         *
+         * @return Result the result, nullptr on a miss
+         */
+        Result find( size_t terrain_version, const coordinates<size_t>& origin, uint32_t range, uint8_t policy );
+
+        void store( size_t terrain_version, const coordinates<size_t>& origin, uint32_t range, uint8_t policy, std::vector<uint32_t> visible );
+
+        void clear();
+
+        // Amount of lookups that found a result and that didn't since the counters were last reset
+        [[nodiscard]]
+        size_t hits() const;
+        [[nodiscard]]
+        size_t misses() const;
+        void reset_counters();
+
+        // Amount of cached results
+        [[nodiscard]]
+        size_t size() const;
+
+        // Amount of tiles in the cached results
+        [[nodiscard]]
+        size_t stored_tiles() const;
+
+    private:
+        struct Key
+        {
+            size_t y;
+            size_t x;
+            uint32_t range;
+            uint8_t policy;
+
+            bool operator == ( const Key& ) const = default;
+        };
+
+        struct KeyHash
+        {
+            size_t operator () ( const Key& key ) const noexcept
+            {
+                return ( key.y * 0x9E3779B97F4A7C15ull ) ^ ( key.x * 0xC2B2AE3D27D4EB4Full ) ^ ( size_t( key.range ) << 8 ) ^ key.policy;
+            }
+        };
+
+        // The cache is cleared when it would hold more tiles than this (16 MB of indices), the same origins tend to be
+        // asked again soon after each other
+        static constexpr size_t max_tiles = 1 << 22;
+
+        mutable std::mutex mutex_;
+        std::unordered_map< Key, Result, KeyHash > results_;
+        size_t stored_tiles_ = 0;
+        size_t terrain_version_ = 0;
+        size_t hits_ = 0;
+        size_t misses_ = 0;
+};
@@ -2,8 +2,10 @@
 #include <algorithm>
 #include <cassert>
 #include <variant>
+#include <utility>
 
 #include "enemy_ai.hpp"
+#include "mcts_ai.hpp"
 #include "game.hpp"
 #include "map.hpp"
 #include "action.hpp"
@@ -44,39 +46,61 @@ std::vector<Unit*> Game::get_units() {
 }
 
 Unit* Game::get_unit(int id) {
-    std::vector<Unit*> all_units = get_units();
-    auto it = std::find_if(all_units.begin(), all_units.end(), [id](Unit* unit) {
-        return unit->get_id() == id;
-    });
+    for (Team& team : teams_) {
+        if (Unit* unit = team.get_unit(id); unit != nullptr) {
+            return unit;
+        }
+    }
 
-    assert(it != all_units.end() && "Specified unit does not exist");
-    return *it;
+    assert(false && "Specified unit does not exist");
+    return nullptr;
 }
 
-int Game::get_unit_team_id(int unit_id) const {
-    for (const Team& team : teams_) {
-        const std::vector<Unit>& team_units = team.get_units();
+Unit* Game::get_unit(const UnitHandle& handle) {
+    for (Team& team : teams_) {
+        if (team.get_id() == handle.team_id) {
+            return team.get_unit(handle);
+        }
+    }
 
-        // Search for unit with given ID inside of each team
-        auto it = std::find_if(team_units.begin(), team_units.end(), [unit_id](const Unit& unit) {
-            return unit.get_id() == unit_id;
-        });
+    return nullptr;
+}
 
-        //If unit is found, return team's id
-        if (it == team_units.end()) continue;
-        return team.get_id();
+int Game::get_unit_team_id(int unit_id) const {
+    for (const Team& team : teams_) {
+        if (team.has_unit(unit_id)) return team.get_id();
     }
 
     assert(false && "Unit with specified ID does not exist in this game");
     return 0;
 }
 
+UnitHandle Game::add_unit(int team_id, Unit unit, const coordinates<size_t>& location) {
+    if (!map_.can_move_to_coords(location)) return {};
+
+    Team& team = get_team_by_id(team_id);
+    const UnitHandle handle = team.add_unit(std::move(unit));
+    map_.add_unit(location, team.get_unit(handle));
+    update_visible_tiles();
+    return handle;
+}
+
+bool Game::remove_unit(const UnitHandle& handle) {
+    Unit* unit = get_unit(handle);
+    if (unit == nullptr) return false;
+
+    map_.remove_unit(map_.get_unit_location(unit));
+    get_team_by_id(handle.team_id).remove_unit(unit->get_id());
+    update_visible_tiles();
+    return true;
+}
+
 coordinates<size_t> Game::get_unit_location(int id) {
     return map_.get_unit_location(get_unit(id));
 }
 
-std::unordered_map<int, std::vector<Unit>*> Game::get_units_map() {
-    std::unordered_map<int, std::vector<Unit>*> units_map;
+std::unordered_map<int, SlotMap<Unit>*> Game::get_units_map() {
+    std::unordered_map<int, SlotMap<Unit>*> units_map;
     for (Team& team : get_teams()) {
         units_map[team.get_id()] = &team.get_units();
     }
@@ -87,29 +111,70 @@ std::unordered_map<int, std::vector<Unit>*> Game::get_units_map() {
 void Game::update_visible_tiles() {
     if (!(active_team_idx_ >= 0 && active_team_idx_ < teams_.size())) {
         visible_coords.clear();
+        visible_team_id_ = -1;
+        // The tiles that were visible are the ones that turn hidden
+        if (visible_grid_.any()) {
+            visibility_changes_ = std::move(visible_grid_);
+            visible_grid_ = BitGrid();
+            visibility_version_++;
+        }
         return;
     }
 
-    std::vector<Unit*> active_units = teams_[active_team_idx_].get_alive_units();
-    std::vector<coordinates<size_t>> visible_coords_vec;
-    for (Unit* unit : active_units) {
-        coordinates<size_t> unit_location = map_.get_unit_location(unit);
-        std::vector<coordinates<size_t>> visible_coords_unit = map_.tiles_unit_sees(unit_location, unit_consts.visual_range);
-        visible_coords_vec.insert(visible_coords_vec.end(),visible_coords_unit.begin(),visible_coords_unit.end());
+    Team& active_team = teams_[active_team_idx_];
+    TeamVisibility& visibility = team_visibility_[active_team.get_id()];
+    std::vector<Unit*> alive_units = active_team.get_alive_units();
+    if (visibility_pool_ == nullptr && visibility_jobs_ != 1 && alive_units.size() >= TeamVisibility::parallel_threshold) {
+        visibility_pool_ = std::make_shared<ThreadPool>(visibility_jobs_);
+    }
+    visibility.update(map_, alive_units, unit_consts.visual_range, visibility_pool_.get());
+
+    // Nothing to copy if the same team still sees the same tiles
+    if (visible_team_id_ == active_team.get_id() && visible_team_version_ == visibility.version()) return;
+    visible_team_id_ = active_team.get_id();
+    visible_team_version_ = visibility.version();
+
+    const BitGrid& visible = visibility.visible_grid();
+    if (visible_grid_.width() == visible.width() && visible_grid_.height() == visible.height()) {
+        // Units moving inside of what the team already sees don't change the visible tiles, and then the changes
+        // of the last version have to stay as they are for the renderers that haven't drawn them yet
+        if (changed_tiles_.width() != visible.width() || changed_tiles_.height() != visible.height()) {
+            changed_tiles_ = BitGrid(visible.height(), visible.width());
+        }
+        BitGrid::symmetric_difference(visible_grid_, visible, changed_tiles_);
+        if (!changed_tiles_.any()) return;
+        std::swap(visibility_changes_, changed_tiles_);
+    } else {
+        visibility_changes_ = BitGrid(visible.height(), visible.width(), true);
     }
 
-    std::sort(visible_coords_vec.begin(),visible_coords_vec.end());
-    std::unique(visible_coords_vec.begin(),visible_coords_vec.end());
-    visible_coords = visible_coords_vec;
+    visible_coords = visibility.visible_tiles();
+    visible_grid_ = visible;
+    visibility_version_++;
+}
+
+void Game::set_visibility_jobs(size_t jobs) {
+    visibility_jobs_ = jobs;
+    visibility_pool_.reset();
 }
 
 const std::vector<coordinates<size_t>>& Game::get_visible_tiles() {
     return visible_coords;
 }
 
-void Game::set_ai_controlled_team(int team_id) {
+void Game::set_ai_controlled_team(int team_id, AIType type) {
     Team& team = get_team_by_id(team_id);
-    enemy_ai_ = std::make_unique<EnemyAI>(*this, team);
+    if (type == AIType::monte_carlo) {
+        enemy_ai_ = std::make_shared<MctsAI>(*this, team);
+    } else {
+        enemy_ai_ = std::make_shared<EnemyAI>(*this, team);
+    }
+    if (ai_planning_jobs_) enemy_ai_->set_planning_jobs(*ai_planning_jobs_);
+}
+
+void Game::set_ai_planning_jobs(size_t jobs) {
+    ai_planning_jobs_ = jobs;
+    if (enemy_ai_ != nullptr) enemy_ai_->set_planning_jobs(jobs);
 }
 
 bool Game::add_action(std::shared_ptr<Action> action, int team_id) {
@@ -137,7 +202,9 @@ bool Game::add_action(std::shared_ptr<Action> action, int team_id) {
 
 void Game::execute_action(std::shared_ptr<Action> action) {
     if (action == nullptr) return;
-    action->execute(*this, get_unit_location(action->get_unit().get_id()));
+    // The unit may have been removed after the action was queued
+    if (action->get_unit_handle().valid() && get_unit(action->get_unit_handle()) == nullptr) return;
+    action->execute(*this, map_.get_unit_location(&action->get_unit()));
 }
 
 bool Game::undo_action(int team_id) {
@@ -148,6 +215,9 @@ bool Game::undo_action(int team_id) {
     if (action == nullptr) {
         return false;
     }
+    if (action->get_unit_handle().valid() && get_unit(action->get_unit_handle()) == nullptr) {
+        return true;
+    }
 
     Unit& executing_unit = action->get_unit();
 
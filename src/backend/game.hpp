@@ -9,14 +9,17 @@
 #include <sstream>
 #include <vector>
 #include <unordered_set>
+#include <optional>
 
 #include "map.hpp"
 #include "team.hpp"
 #include "unit.hpp"
 #include "map_builder.hpp"
+#include "team_visibility.hpp"
+#include "ai_controller.hpp"
 
 class Action;
-class EnemyAI;
+class AIController;
 
 //Game class that instances the playing of a level
 class Game {
@@ -50,16 +53,37 @@ public:
     int get_unit_amount() const;
 
     //return vector of pointers to units in all the teams. Pointers since you can't have vector of references.
-    //Ownership of units is still in each Team, care for dangling pointers etc. Units should however live as long as Game does (unless we plan to remove them on death?)
+    //Ownership of units is still in each Team. A unit stays at the same address until it is removed from its team,
+    //so the pointers are valid as long as no unit is removed; keep a UnitHandle where that can happen.
     [[nodiscard]]
     std::vector<Unit*> get_units();
 
     [[nodiscard]]
     Unit* get_unit(int id);
 
+    /**
+     * @brief The unit of the handle, nullptr if it has been removed from its team
+     */
+    [[nodiscard]]
+    Unit* get_unit(const UnitHandle& handle);
+
     [[nodiscard]]
     int get_unit_team_id(int unit_id) const;
 
+    /**
+     * @brief Adds a unit to a team of a running game and places it on the map, for reinforcements
+     *
+     * @return UnitHandle the handle of the unit, not valid if <location> can't be moved to
+     */
+    UnitHandle add_unit(int team_id, Unit unit, const coordinates<size_t>& location);
+
+    /**
+     * @brief Removes the unit from the map and from its team. The queued actions of the unit are skipped after this.
+     *
+     * @return bool false if the unit had already been removed
+     */
+    bool remove_unit(const UnitHandle& handle);
+
     [[nodiscard]]
     coordinates<size_t> get_unit_location(int id);
 
@@ -71,12 +95,68 @@ public:
      */
     const std::vector<coordinates<size_t>>& get_visible_tiles();
 
-    void set_ai_controlled_team(int team_id);
+    /**
+     * @brief Sets the amount of threads the views of the units are calculated on in update_visible_tiles.
+     * 1 (the default) calculates them on the calling thread and 0 uses the amount of hardware threads. The pool is only
+     * used for teams of TeamVisibility::parallel_threshold or more alive units. The visible tiles are the same with any amount of jobs.
+     */
+    void set_visibility_jobs(size_t jobs);
+
+    /**
+     * @brief Checks if the active team sees the tile. Constant time, used by the rendering classes for every tile.
+     *
+     * @returns False for coords outside of the map.
+     */
+    [[nodiscard]]
+    inline bool is_visible(const coordinates<size_t>& coords) const {
+        return coords.x < visible_grid_.width() && coords.y < visible_grid_.height() && visible_grid_.test(coords);
+    }
+
+    /**
+     * @brief Incremented every time the visible tiles change, so renderers can skip work when it stays the same.
+     */
+    [[nodiscard]]
+    inline size_t visibility_version() const {
+        return visibility_version_;
+    }
+
+    /**
+     * @brief The tiles that turned visible or hidden when visibility_version was last incremented. Stays the same until
+     * the visible tiles change again. Lets the fog of war be redrawn only where it changed.
+     */
+    [[nodiscard]]
+    inline const BitGrid& visibility_changes() const {
+        return visibility_changes_;
+    }
+
+    /**
+     * @brief Lets an AI play the team, the AI plans the team's turns when it becomes active
+     *
+     * @param team_id the team the AI controls
+     * @param type the kind of AI, the rules of EnemyAI by default
+     */
+    void set_ai_controlled_team(int team_id, AIType type = AIType::rules);
+
+    /**
+     * @brief The AI that controls a team, nullptr if no team is controlled by an AI
+     */
+    [[nodiscard]]
+    inline std::shared_ptr<AIController> get_ai_controller() const {
+        return enemy_ai_;
+    }
+
+    /**
+     * @brief Sets the amount of threads the AI plans its team's turns on, see AIController::set_planning_jobs.
+     * Until it's set every AI keeps its own default: EnemyAI plans the units one after another and MctsAI
+     * searches on all the hardware threads.
+     */
+    void set_ai_planning_jobs(size_t jobs);
 
     /**
      * @brief Used map_ to calculate all visible coords for the active team.
      * This method will be called on on the start of the game, after turn changes
-     * and after movement_action is executed.
+     * and after movement_action is executed. Only the views of the units that moved
+     * since the last call are recalculated, unless the terrain has changed.
      */
     void update_visible_tiles();
     /**
@@ -91,7 +171,7 @@ public:
     //return all units as values in an unordered_map, keys being their team's id
     //pointers since you cant store references in map
     [[nodiscard]]
-    std::unordered_map<int, std::vector<Unit>*> get_units_map();
+    std::unordered_map<int, SlotMap<Unit>*> get_units_map();
 
     /**
      * @brief Executes the action given as parameter
@@ -146,8 +226,23 @@ private:
     std::stringstream output_;
     int active_team_idx_ = -1;
     std::vector<coordinates<size_t>> visible_coords;
-
-    std::shared_ptr<EnemyAI> enemy_ai_;
+    // What each team sees, keyed by team id. Updated incrementally by update_visible_tiles
+    std::unordered_map<int, TeamVisibility> team_visibility_;
+    // The visible tiles of the active team as bits, and the team and TeamVisibility version they were copied from
+    BitGrid visible_grid_;
+    BitGrid visibility_changes_;
+    // Scratch grid the changes are calculated into, so visibility_changes_ is only replaced when the tiles changed
+    BitGrid changed_tiles_;
+    // Threads for calculating the views of big teams, created when first needed. Shared so that Game stays copyable
+    size_t visibility_jobs_ = 1;
+    std::shared_ptr<ThreadPool> visibility_pool_;
+    size_t visibility_version_ = 0;
+    int visible_team_id_ = -1;
+    size_t visible_team_version_ = 0;
+
+    std::shared_ptr<AIController> enemy_ai_;
+    // Only passed to the AI if it was set, otherwise the AI keeps its own default
+    std::optional<size_t> ai_planning_jobs_;
 
     /**
      * @brief Increments active_team_idx_. If end then jump to begin.
@@ -0,0 +1,342 @@
+#include <algorithm>
+#include <cassert>
+
+#include "game_state.hpp"
+#include "game.hpp"
+#include "team.hpp"
+#include "unit.hpp"
+#include "item.hpp"
+#include "action.hpp"
+#include "building.hpp"
+#include "const_items.hpp"
+#include "map.hpp"
+#include "fov.hpp"
+#include "range_tables.hpp"
+
+namespace {
+
+size_t steps_between(const coordinates<size_t>& a, const coordinates<size_t>& b) {
+    return (a.x > b.x ? a.x - b.x : b.x - a.x) + (a.y > b.y ? a.y - b.y : b.y - a.y);
+}
+
+uint8_t part_bit(BuildingPartType type) {
+    return uint8_t(1) << uint8_t(type);
+}
+
+// The parts that belong to the same kind of building as <type>
+uint8_t building_kind_bits(BuildingPartType type) {
+    return uint8_t(type) <= uint8_t(BuildingPartType::TurretBarrel) ? 0b0011 : 0b1100;
+}
+
+GameState::ItemStats stats_of(const Item& item) {
+    GameState::ItemStats stats{};
+    if (item.is_weapon()) {
+        const Weapon& weapon = static_cast<const Weapon&>(item);
+        stats.kind = GameState::ItemStats::Kind::weapon;
+        stats.accuracy = weapon.get_accuracy();
+        stats.damage = weapon.get_damage();
+        stats.falloff = weapon.get_falloff();
+        stats.area_of_effect = weapon.get_aoe();
+    } else if (item.is_healing_item()) {
+        const HealingItem& healing = static_cast<const HealingItem&>(item);
+        stats.kind = GameState::ItemStats::Kind::healing;
+        stats.heal_amount = healing.get_heal_amount();
+        stats.area_of_effect = healing.get_aoe();
+    } else {
+        stats.kind = GameState::ItemStats::Kind::building_part;
+        stats.part_type = static_cast<const BuildingPart&>(item).get_part_type();
+    }
+    return stats;
+}
+
+} // namespace
+
+
+GameState::GameState(const Game& game) {
+    const Map& map = game.get_map();
+    auto shared = std::make_shared<Shared>();
+    shared->width = map.width();
+    shared->height = map.height();
+    shared->walkable = map.walkable_layer();
+    shared->see_through = map.see_through_layer();
+    shared->shoot_through = map.shoot_through_layer();
+    shared->buildable = BitGrid(map.height(), map.width());
+    for (size_t y = 0; y < map.height(); y++) {
+        for (size_t x = 0; x < map.width(); x++) {
+            shared->buildable.assign(y, x, map.can_build_on(y, x));
+        }
+    }
+
+    // Every item once, however many units carry it
+    auto item_index = [&shared](const Item& item) {
+        const auto [it, added] = shared->item_indices.try_emplace(&item, shared->items.size());
+        if (added) shared->items.push_back(stats_of(item));
+        return it->second;
+    };
+    shared->turret_item = item_index(*ConstItem::turret_weapon);
+    shared->medic_tent_item = item_index(*ConstItem::medic_tent_heal_item);
+
+    occupants_.assign(map.width() * map.height(), no_unit);
+    for (const Team& team : game.get_teams()) {
+        for (const Unit& unit : team.get_units()) {
+            UnitState state{};
+            state.id = unit.get_id();
+            state.team_id = team.get_id();
+            state.location = map.get_unit_location(&unit);
+            state.hp = unit.get_hp();
+            state.first_item = shared->unit_items.size();
+            for (const std::shared_ptr<const Item>& item : unit.get_inventory()) {
+                shared->unit_items.push_back(item_index(*item));
+            }
+            state.item_count = shared->unit_items.size() - state.first_item;
+
+            shared->unit_indices.emplace(state.id, units_.size());
+            occupants_[state.location.y * map.width() + state.location.x] = units_.size();
+            units_.push_back(state);
+        }
+    }
+
+    for (const Map::BuildingEntry& entry : map.get_building_entries()) {
+        BuildingState building{entry.location, 0};
+        if (const Turret* turret = dynamic_cast<const Turret*>(entry.building.get())) {
+            if (turret->has_legs()) building.parts |= part_bit(BuildingPartType::TurretLegs);
+            if (turret->has_barrel()) building.parts |= part_bit(BuildingPartType::TurretBarrel);
+        } else if (const MedicTent* tent = dynamic_cast<const MedicTent*>(entry.building.get())) {
+            if (tent->has_medkit()) building.parts |= part_bit(BuildingPartType::MedicTentMedkit);
+            if (tent->has_tent()) building.parts |= part_bit(BuildingPartType::MedicTentTent);
+        }
+        buildings_.push_back(building);
+    }
+
+    shared_ = std::move(shared);
+}
+
+
+GameState::Move GameState::move_of(const Action& action) const {
+    Move move{};
+    move.unit = unit_index(action.get_unit().get_id());
+    move.target = action.target();
+    if (action.is_movement()) {
+        move.kind = Move::Kind::movement;
+        return move;
+    }
+
+    const Item* item = nullptr;
+    if (const WeaponAction* weapon_action = dynamic_cast<const WeaponAction*>(&action)) {
+        item = &weapon_action->get_weapon();
+    } else if (const HealingAction* healing_action = dynamic_cast<const HealingAction*>(&action)) {
+        item = &healing_action->get_healing_item();
+    } else if (const BuildingAction* building_action = dynamic_cast<const BuildingAction*>(&action)) {
+        item = &building_action->get_part();
+    }
+    assert(item != nullptr && "Unknown kind of action");
+
+    move.kind = Move::Kind::use_item;
+    move.item = shared_->item_indices.at(item);
+    return move;
+}
+
+
+void GameState::make(const Move& move, std::mt19937& rng) {
+    move_starts_.push_back(changes_.size());
+    if (move.unit >= units_.size()) return;
+
+    if (move.kind == Move::Kind::movement) {
+        move_unit(move.unit, move.target);
+        return;
+    }
+    // Dead units can't use their items, like in the actions
+    if (units_[move.unit].hp <= 0) return;
+
+    const ItemStats& item = shared_->items[move.item];
+    switch (item.kind) {
+        case ItemStats::Kind::weapon:
+            use_weapon(move.unit, item, move.target, rng);
+            break;
+        case ItemStats::Kind::healing:
+            use_healing(item, move.target);
+            break;
+        case ItemStats::Kind::building_part:
+            add_building_part(item, move.target);
+            break;
+    }
+}
+
+
+void GameState::unmake() {
+    assert(!move_starts_.empty());
+    const size_t start = move_starts_.back();
+    move_starts_.pop_back();
+
+    // The changes are undone last first, so a value changed twice ends up as it was before both
+    while (changes_.size() > start) {
+        const Change& change = changes_.back();
+        switch (change.kind) {
+            case Change::Kind::hp:
+                units_[change.index].hp = change.old_value;
+                break;
+            case Change::Kind::location: {
+                UnitState& unit = units_[change.index];
+                occupants_[unit.location.y * width() + unit.location.x] = no_unit;
+                occupants_[change.old_location.y * width() + change.old_location.x] = change.index;
+                unit.location = change.old_location;
+                break;
+            }
+            case Change::Kind::building_parts:
+                buildings_[change.index].parts = change.old_value;
+                break;
+            case Change::Kind::building_added:
+                buildings_.pop_back();
+                break;
+        }
+        changes_.pop_back();
+    }
+}
+
+
+void GameState::change_hp(UnitIndex unit, int amount) {
+    if (move_starts_.empty()) move_starts_.push_back(changes_.size());
+    set_hp(unit, std::min(units_[unit].hp + amount, unit_consts.max_hp));
+}
+
+
+GameState::UnitIndex GameState::unit_index(int unit_id) const {
+    const auto it = shared_->unit_indices.find(unit_id);
+    return it == shared_->unit_indices.end() ? no_unit : it->second;
+}
+
+
+int GameState::building_at(const coordinates<size_t>& coords) const {
+    for (size_t i = 0; i < buildings_.size(); i++) {
+        if (buildings_[i].location == coords) return i;
+    }
+    return -1;
+}
+
+
+bool GameState::can_move_to(const coordinates<size_t>& coords) const {
+    return coords.x < width() && coords.y < height() && shared_->walkable.test(coords) && unit_at(coords) == no_unit;
+}
+
+
+bool GameState::can_see(const coordinates<size_t>& from, const coordinates<size_t>& to, uint32_t range) const {
+    return Fov::is_visible(from, to, range, width(), height(),
+        [this](int64_t y, int64_t x) { return !shared_->see_through.test(y, x); });
+}
+
+
+bool GameState::operator==(const GameState& other) const {
+    auto same_unit = [](const UnitState& a, const UnitState& b) {
+        return a.id == b.id && a.team_id == b.team_id && a.location == b.location && a.hp == b.hp;
+    };
+    auto same_building = [](const BuildingState& a, const BuildingState& b) {
+        return a.location == b.location && a.parts == b.parts;
+    };
+    return std::equal(units_.begin(), units_.end(), other.units_.begin(), other.units_.end(), same_unit) &&
+        std::equal(buildings_.begin(), buildings_.end(), other.buildings_.begin(), other.buildings_.end(), same_building);
+}
+
+
+void GameState::set_hp(UnitIndex unit, int hp) {
+    changes_.push_back({Change::Kind::hp, unit, units_[unit].hp, {}});
+    units_[unit].hp = hp;
+}
+
+
+void GameState::set_location(UnitIndex unit, const coordinates<size_t>& location) {
+    UnitState& state = units_[unit];
+    changes_.push_back({Change::Kind::location, unit, 0, state.location});
+    occupants_[state.location.y * width() + state.location.x] = no_unit;
+    occupants_[location.y * width() + location.x] = unit;
+    state.location = location;
+}
+
+
+void GameState::move_unit(UnitIndex unit, const coordinates<size_t>& target) {
+    // The same checks as Map::move_unit
+    if (target == units_[unit].location || !can_move_to(target)) return;
+    set_location(unit, target);
+}
+
+
+void GameState::use_weapon(UnitIndex unit, const ItemStats& weapon, const coordinates<size_t>& target, std::mt19937& rng) {
+    if (target.x >= width() || target.y >= height()) return;
+
+    // A hit is a roll of 0-100 that is at most the accuracy, like Unit::deal_damage
+    std::uniform_int_distribution<int> roll(0, 100);
+    auto attack = [&](UnitIndex target_unit, size_t distance) {
+        if (roll(rng) > weapon.accuracy) return;
+        const int damage = Weapon::calculate_damage_dealt(weapon.damage, weapon.falloff, distance);
+        set_hp(target_unit, std::min(units_[target_unit].hp - damage, unit_consts.max_hp));
+    };
+
+    if (weapon.area_of_effect == 0) {
+        const UnitIndex target_unit = unit_at(target);
+        if (target_unit != no_unit) attack(target_unit, steps_between(units_[unit].location, target));
+        return;
+    }
+
+    // The damage of an area of effect falls off from its center
+    for (UnitIndex target_unit : units_in_area(target, weapon.area_of_effect)) {
+        attack(target_unit, steps_between(target, units_[target_unit].location));
+    }
+}
+
+
+void GameState::use_healing(const ItemStats& healing, const coordinates<size_t>& target) {
+    if (target.x >= width() || target.y >= height()) return;
+
+    // Dead units can't be healed, like in Unit::heal
+    auto heal = [&](UnitIndex target_unit) {
+        const int hp = units_[target_unit].hp;
+        if (hp > 0) set_hp(target_unit, std::min(hp + healing.heal_amount, unit_consts.max_hp));
+    };
+
+    if (healing.area_of_effect == 0) {
+        const UnitIndex target_unit = unit_at(target);
+        if (target_unit != no_unit) heal(target_unit);
+        return;
+    }
+
+    for (UnitIndex target_unit : units_in_area(target, healing.area_of_effect)) {
+        heal(target_unit);
+    }
+}
+
+
+void GameState::add_building_part(const ItemStats& part, const coordinates<size_t>& target) {
+    if (target.x >= width() || target.y >= height()) return;
+
+    const int index = building_at(target);
+    if (index >= 0) {
+        // Like Building::add_part, the part has to fit the building and not be there yet
+        BuildingState& building = buildings_[index];
+        if ((building.parts & ~building_kind_bits(part.part_type)) != 0 || (building.parts & part_bit(part.part_type)) != 0) return;
+        changes_.push_back({Change::Kind::building_parts, uint32_t(index), building.parts, {}});
+        building.parts |= part_bit(part.part_type);
+    } else if (shared_->buildable.test(target)) {
+        changes_.push_back({Change::Kind::building_added, uint32_t(buildings_.size()), 0, {}});
+        buildings_.push_back({target, part_bit(part.part_type)});
+    }
+}
+
+
+std::vector<GameState::UnitIndex> GameState::units_in_area(const coordinates<size_t>& center, int range) const {
+    // The occupied tiles of the disc around <center> row by row, so the units are in the same order as Map::get_aoe_affected_unit_coords
+    std::vector<UnitIndex> area_units;
+    const size_t top = center.y > size_t(range) ? center.y - range : 0;
+    const size_t bottom = std::min<size_t>(center.y + range + 1, height());
+    for (size_t y = top; y < bottom; y++) {
+        const size_t half_width = RangeTables::disc_half_width(range, int64_t(y) - int64_t(center.y));
+        const size_t left = center.x > half_width ? center.x - half_width : 0;
+        const size_t right = std::min<size_t>(center.x + half_width + 1, width());
+        for (size_t x = left; x < right; x++) {
+            const UnitIndex unit = occupants_[y * width() + x];
+            if (unit == no_unit) continue;
+            const bool in_sight = Fov::is_visible(center, coordinates<size_t>(x, y), range, width(), height(),
+                [this](int64_t ty, int64_t tx) { return !shared_->shoot_through.test(ty, tx); });
+            if (in_sight) area_units.push_back(unit);
+        }
+    }
+    return area_units;
+}
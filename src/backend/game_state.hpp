@@ -0,0 +1,225 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include <random>
+#include <cstdint>
+#include <unordered_map>
+
+#include "coordinates.hpp"
+#include "bit_grid.hpp"
+#include "building_part_type.hpp"
+
+class Game;
+class Item;
+class Action;
+
+/**
+ * @brief A compact copy of a Game for searches and simulations: the units, the buildings and the terrain without any pointers,
+ * so a copy is a self-contained state that can be changed freely. Units, items and buildings are referred to by their index.
+ *
+ * What doesn't change during a game (the terrain, the stats of the items and the lookups from the Game's objects to the indices)
+ * is shared between the copies, so a copy only copies the units, the buildings and a tile -> unit index grid.
+ *
+ * Actions are applied with make and taken back with unmake: every change make does is recorded on an undo stack, so a search can
+ * go down and back up a line of play on one state without copying it. The outcomes of the attacks are rolled with the given
+ * random numbers the same way Unit::deal_damage rolls them.
+ */
+class GameState {
+public:
+    using UnitIndex = uint32_t;
+    static constexpr UnitIndex no_unit = UINT32_MAX;
+
+    // The numbers of an item, the kind of item decides which of them are used
+    struct ItemStats {
+        enum class Kind : uint8_t { weapon, healing, building_part };
+
+        Kind kind;
+        int accuracy;
+        int damage;
+        int falloff;
+        int area_of_effect;
+        int heal_amount;
+        BuildingPartType part_type;
+    };
+
+    struct UnitState {
+        int id;
+        int team_id;
+        coordinates<size_t> location;
+        int hp;
+        // the items of the unit in unit_items()
+        uint32_t first_item;
+        uint32_t item_count;
+    };
+
+    struct BuildingState {
+        coordinates<size_t> location;
+        // bit (1 << BuildingPartType) is set for every part the building has
+        uint8_t parts;
+    };
+
+    // An action as indices: a movement to <target>, or using the item at <item> of items() on <target>
+    struct Move {
+        enum class Kind : uint8_t { movement, use_item };
+
+        Kind kind;
+        UnitIndex unit;
+        uint32_t item;
+        coordinates<size_t> target;
+    };
+
+    /**
+     * @brief Copies the units and buildings of <game> and the terrain of its map
+     */
+    explicit GameState(const Game& game);
+
+    /**
+     * @brief The Move of an action of <game>'s units. The items of the buildings can be used too.
+     */
+    [[nodiscard]]
+    Move move_of(const Action& action) const;
+
+    /**
+     * @brief Applies the move, recording the changes so unmake can take it back. Moves that can't be done (a movement to an
+     * occupied tile, healing an empty tile) don't change anything but are still recorded.
+     *
+     * @param rng rolls the hits of the attacks
+     */
+    void make(const Move& move, std::mt19937& rng);
+
+    /**
+     * @brief Takes back the last move that hasn't been taken back yet
+     */
+    void unmake();
+
+    /**
+     * @brief Changes the HP of a unit as a recorded change of the last move, for simulations that model something without an action.
+     * Before any move has been made the change is a move of its own.
+     */
+    void change_hp(UnitIndex unit, int amount);
+
+    /**
+     * @brief The amount of moves that can be taken back
+     */
+    [[nodiscard]]
+    inline size_t depth() const {
+        return move_starts_.size();
+    }
+
+    [[nodiscard]]
+    inline const std::vector<UnitState>& units() const {
+        return units_;
+    }
+
+    [[nodiscard]]
+    inline const std::vector<BuildingState>& buildings() const {
+        return buildings_;
+    }
+
+    [[nodiscard]]
+    inline const std::vector<ItemStats>& items() const {
+        return shared_->items;
+    }
+
+    /**
+     * @brief The items of every unit as indices of items(), see UnitState::first_item
+     */
+    [[nodiscard]]
+    inline const std::vector<uint32_t>& unit_items() const {
+        return shared_->unit_items;
+    }
+
+    [[nodiscard]]
+    inline size_t width() const {
+        return shared_->width;
+    }
+
+    [[nodiscard]]
+    inline size_t height() const {
+        return shared_->height;
+    }
+
+    /**
+     * @brief The unit on the tile, no_unit if there's none. Dead units stay on their tile like on the Map.
+     */
+    [[nodiscard]]
+    inline UnitIndex unit_at(const coordinates<size_t>& coords) const {
+        return occupants_[coords.y * width() + coords.x];
+    }
+
+    /**
+     * @brief The index of the unit with the id in units(), no_unit if the game didn't have it
+     */
+    [[nodiscard]]
+    UnitIndex unit_index(int unit_id) const;
+
+    /**
+     * @brief The index of the building on the tile in buildings(), -1 if there's none
+     */
+    [[nodiscard]]
+    int building_at(const coordinates<size_t>& coords) const;
+
+    [[nodiscard]]
+    bool can_move_to(const coordinates<size_t>& coords) const;
+
+    /**
+     * @brief Line of sight through the terrain that can be seen through, the same as Map::has_line_of_sight<LosPolicy::SeeThrough>
+     */
+    [[nodiscard]]
+    bool can_see(const coordinates<size_t>& from, const coordinates<size_t>& to, uint32_t range) const;
+
+    /**
+     * @brief The same units, buildings and HP. The undo stacks aren't compared.
+     */
+    [[nodiscard]]
+    bool operator==(const GameState& other) const;
+
+private:
+    // Everything that stays the same while the state changes, shared between the copies
+    struct Shared {
+        size_t width;
+        size_t height;
+        BitGrid walkable;
+        BitGrid see_through;
+        BitGrid shoot_through;
+        BitGrid buildable;
+        std::vector<ItemStats> items;
+        std::vector<uint32_t> unit_items;
+        // the lookups from the objects of the game, only used by move_of
+        std::unordered_map<const Item*, uint32_t> item_indices;
+        std::unordered_map<int, UnitIndex> unit_indices;
+        // the items that using a turret and a medic tent gives
+        uint32_t turret_item;
+        uint32_t medic_tent_item;
+    };
+
+    // A recorded change, undone by putting the old value back
+    struct Change {
+        enum class Kind : uint8_t { hp, location, building_parts, building_added };
+
+        Kind kind;
+        uint32_t index;
+        int old_value;
+        coordinates<size_t> old_location;
+    };
+
+    std::shared_ptr<const Shared> shared_;
+    std::vector<UnitState> units_;
+    std::vector<BuildingState> buildings_;
+    std::vector<UnitIndex> occupants_;
+
+    std::vector<Change> changes_;
+    // where the changes of every move that can be taken back start
+    std::vector<size_t> move_starts_;
+
+    void set_hp(UnitIndex unit, int hp);
+    void set_location(UnitIndex unit, const coordinates<size_t>& location);
+
+    void move_unit(UnitIndex unit, const coordinates<size_t>& target);
+    void use_weapon(UnitIndex unit, const ItemStats& weapon, const coordinates<size_t>& target, std::mt19937& rng);
+    void use_healing(const ItemStats& healing, const coordinates<size_t>& target);
+    void add_building_part(const ItemStats& part, const coordinates<size_t>& target);
+
+    // the units within <range> of <center> that it has a line of sight to through terrain that can be shot through, like Map::get_aoe_affected_unit_coords
+    std::vector<UnitIndex> units_in_area(const coordinates<size_t>& center, int range) const;
+};
@@ -0,0 +1,354 @@
+#include <queue>
+#include <limits>
+#include <algorithm>
+#include <functional>
+#include <utility>
+#include <cassert>
+
+#include "hierarchical_pathfinder.hpp"
+#include "map.hpp"
+
+
+static const uint32_t no_path = std::numeric_limits<uint32_t>::max();
+
+
+HierarchicalPathfinder::HierarchicalPathfinder( const Map& map, size_t cluster_size ) :
+    cluster_size_( cluster_size ),
+    cluster_columns_( ( map.width() + cluster_size - 1 ) / cluster_size ),
+    cluster_rows_( ( map.height() + cluster_size - 1 ) / cluster_size ),
+    borders_( cluster_columns_ * cluster_rows_ * 2 )
+{
+    for ( size_t row = 0; row < cluster_rows_; row++ ) {
+        for ( size_t column = 0; column < cluster_columns_; column++ ) {
+            clusters_.push_back( {
+                row * cluster_size_,
+                column * cluster_size_,
+                std::min( ( row + 1 ) * cluster_size_, map.height() ),
+                std::min( ( column + 1 ) * cluster_size_, map.width() ),
+                false,
+                {}
+            } );
+        }
+    }
+
+    for ( uint32_t cluster = 0; cluster < clusters_.size(); cluster++ ) {
+        build_border( map, cluster, false );
+        build_border( map, cluster, true );
+    }
+
+    for ( uint32_t cluster = 0; cluster < clusters_.size(); cluster++ ) {
+        build_edges( map, cluster );
+    }
+}
+
+
+void HierarchicalPathfinder::mark_dirty( size_t y, size_t x ) {
+    const uint32_t cluster = cluster_of( y, x );
+    if ( !clusters_[cluster].dirty ) {
+        clusters_[cluster].dirty = true;
+        dirty_clusters_.push_back( cluster );
+    }
+}
+
+
+std::vector<uint32_t>& HierarchicalPathfinder::cluster_distance() {
+    thread_local std::vector<uint32_t> distance;
+    return distance;
+}
+
+
+size_t HierarchicalPathfinder::node_count() const {
+    return nodes_.size() - free_nodes_.size();
+}
+
+
+uint32_t HierarchicalPathfinder::add_node( const coordinates<size_t>& coords, uint32_t cluster ) {
+    uint32_t node;
+    if ( free_nodes_.empty() ) {
+        node = nodes_.size();
+        nodes_.emplace_back();
+    } else {
+        node = free_nodes_.back();
+        free_nodes_.pop_back();
+    }
+
+    nodes_[node].coords = coords;
+    nodes_[node].cluster = cluster;
+    nodes_[node].edges.clear();
+    clusters_[cluster].nodes.push_back( node );
+    return node;
+}
+
+
+void HierarchicalPathfinder::remove_node( uint32_t node ) {
+    std::vector<uint32_t>& cluster_nodes = clusters_[ nodes_[node].cluster ].nodes;
+    cluster_nodes.erase( std::find( cluster_nodes.begin(), cluster_nodes.end(), node ) );
+    nodes_[node].edges.clear();
+    free_nodes_.push_back( node );
+}
+
+
+void HierarchicalPathfinder::build_border( const Map& map, uint32_t cluster, bool south ) {
+    std::vector<uint32_t>& border = borders_[ cluster * 2 + south ];
+    for ( uint32_t node : border ) {
+        remove_node( node );
+    }
+    border.clear();
+
+    const Cluster& current = clusters_[cluster];
+    // The last cluster of a row or a column doesn't have a neighbour on that side
+    if ( south ? current.bottom == map.height() : current.right == map.width() ) return;
+
+    const uint32_t neighbour = south ? cluster + cluster_columns_ : cluster + 1;
+    const size_t length = south ? current.right - current.left : current.bottom - current.top;
+
+    // tile on this side of the border and the one on the neighbour's side, <i> goes along the border
+    auto inside = [&]( size_t i ) {
+        return south ? coordinates<size_t>( current.left + i, current.bottom - 1 ) : coordinates<size_t>( current.right - 1, current.top + i );
+    };
+    auto outside = [&]( size_t i ) {
+        return south ? coordinates<size_t>( current.left + i, current.bottom ) : coordinates<size_t>( current.right, current.top + i );
+    };
+    auto is_open = [&]( size_t i ) {
+        return map.can_move_to_terrain( inside(i) ) && map.can_move_to_terrain( outside(i) );
+    };
+    auto add_transition = [&]( size_t i ) {
+        const uint32_t a = add_node( inside(i), cluster );
+        const uint32_t b = add_node( outside(i), neighbour );
+        nodes_[a].partner = b;
+        nodes_[b].partner = a;
+        border.push_back( a );
+        border.push_back( b );
+    };
+
+    // Every run of open tiles along the border is an entrance
+    size_t i = 0;
+    while ( i < length ) {
+        if ( !is_open(i) ) {
+            i++;
+            continue;
+        }
+
+        const size_t start = i;
+        while ( i < length && is_open(i) ) i++;
+
+        if ( i - start >= long_entrance_length ) {
+            add_transition( start );
+            add_transition( i - 1 );
+        } else {
+            add_transition( start + ( i - start ) / 2 );
+        }
+    }
+}
+
+
+void HierarchicalPathfinder::search_cluster( const Map& map, uint32_t cluster, const coordinates<size_t>& start, bool reverse ) const {
+    using Entry = std::pair<uint32_t, uint32_t>;
+
+    const Cluster& current = clusters_[cluster];
+    const size_t cluster_width = current.right - current.left;
+    std::vector<uint32_t>& distances = cluster_distance();
+    distances.assign( cluster_size_ * cluster_size_, no_path );
+
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue;
+    const uint32_t start_idx = ( start.y - current.top ) * cluster_width + ( start.x - current.left );
+    distances[start_idx] = 0;
+    queue.emplace( 0, start_idx );
+
+    while ( !queue.empty() ) {
+        auto [distance, idx] = queue.top();
+        queue.pop();
+        if ( distance != distances[idx] ) continue;
+
+        const size_t y = current.top + idx / cluster_width;
+        const size_t x = current.left + idx % cluster_width;
+
+        auto relax = [&]( size_t n_y, size_t n_x ) {
+            if ( !map.can_move_to_terrain( n_y, n_x ) ) return;
+
+            // Going backwards the step is onto the current tile instead of the neighbour
+            const uint32_t step = reverse ? map.movement_cost( y, x ) : map.movement_cost( n_y, n_x );
+            const uint32_t neighbour_idx = ( n_y - current.top ) * cluster_width + ( n_x - current.left );
+            if ( distance + step < distances[neighbour_idx] ) {
+                distances[neighbour_idx] = distance + step;
+                queue.emplace( distance + step, neighbour_idx );
+            }
+        };
+
+        if ( y > current.top ) relax( y - 1, x );
+        if ( x + 1 < current.right ) relax( y, x + 1 );
+        if ( y + 1 < current.bottom ) relax( y + 1, x );
+        if ( x > current.left ) relax( y, x - 1 );
+    }
+}
+
+
+uint32_t HierarchicalPathfinder::cluster_distance_to( uint32_t cluster, const coordinates<size_t>& coords ) const {
+    const Cluster& current = clusters_[cluster];
+    return cluster_distance()[ ( coords.y - current.top ) * ( current.right - current.left ) + ( coords.x - current.left ) ];
+}
+
+
+void HierarchicalPathfinder::build_edges( const Map& map, uint32_t cluster ) {
+    const std::vector<uint32_t>& cluster_nodes = clusters_[cluster].nodes;
+
+    for ( uint32_t node : cluster_nodes ) {
+        Node& current = nodes_[node];
+        current.edges.clear();
+        current.edges.push_back( { current.partner, static_cast<uint32_t>( map.movement_cost( nodes_[current.partner].coords ) ) } );
+
+        search_cluster( map, cluster, current.coords, false );
+        for ( uint32_t other : cluster_nodes ) {
+            if ( other == node ) continue;
+
+            const uint32_t cost = cluster_distance_to( cluster, nodes_[other].coords );
+            if ( cost != no_path ) {
+                current.edges.push_back( { other, cost } );
+            }
+        }
+    }
+}
+
+
+void HierarchicalPathfinder::rebuild_dirty( const Map& map ) {
+    if ( dirty_clusters_.empty() ) return;
+
+    std::vector<bool> touched( clusters_.size(), false );
+
+    for ( uint32_t cluster : dirty_clusters_ ) {
+        const size_t row = cluster / cluster_columns_;
+        const size_t column = cluster % cluster_columns_;
+
+        // A cluster shares a border with each of its 4 neighbours, the ones on the north and west are stored by the neighbour
+        build_border( map, cluster, false );
+        build_border( map, cluster, true );
+        touched[cluster] = true;
+        if ( column + 1 < cluster_columns_ ) touched[cluster + 1] = true;
+        if ( row + 1 < cluster_rows_ ) touched[cluster + cluster_columns_] = true;
+
+        if ( column > 0 ) {
+            build_border( map, cluster - 1, false );
+            touched[cluster - 1] = true;
+        }
+        if ( row > 0 ) {
+            build_border( map, cluster - cluster_columns_, true );
+            touched[cluster - cluster_columns_] = true;
+        }
+        clusters_[cluster].dirty = false;
+    }
+    dirty_clusters_.clear();
+
+    for ( uint32_t cluster = 0; cluster < clusters_.size(); cluster++ ) {
+        if ( touched[cluster] ) build_edges( map, cluster );
+    }
+}
+
+
+std::vector< coordinates<size_t> > HierarchicalPathfinder::find_abstract_path( const Map& map, const coordinates<size_t>& location, const coordinates<size_t>& target ) {
+    rebuild_dirty( map );
+    return std::as_const( *this ).find_abstract_path( map, location, target );
+}
+
+
+std::vector< coordinates<size_t> > HierarchicalPathfinder::find_abstract_path( const Map& map, const coordinates<size_t>& location, const coordinates<size_t>& target ) const {
+    assert( dirty_clusters_.empty() && "The dirty clusters have to be rebuilt with rebuild_dirty first" );
+
+    if ( location == target || !map.can_move_to_terrain( target ) ) {
+        return {};
+    }
+
+    // The start and the target are connected to the graph with temporary edges to the nodes of their clusters.
+    // They get the ids after the last node.
+    const uint32_t start_node = nodes_.size();
+    const uint32_t target_node = nodes_.size() + 1;
+    const uint32_t start_cluster = cluster_of( location.y, location.x );
+    const uint32_t target_cluster = cluster_of( target.y, target.x );
+
+    std::vector<Edge> start_edges;
+    search_cluster( map, start_cluster, location, false );
+    for ( uint32_t node : clusters_[start_cluster].nodes ) {
+        const uint32_t cost = cluster_distance_to( start_cluster, nodes_[node].coords );
+        if ( cost != no_path ) start_edges.push_back( { node, cost } );
+    }
+    if ( start_cluster == target_cluster ) {
+        const uint32_t cost = cluster_distance_to( start_cluster, target );
+        if ( cost != no_path ) start_edges.push_back( { target_node, cost } );
+    }
+
+    // cost from each node of the target's cluster to the target
+    std::vector<uint32_t> target_cost( nodes_.size(), no_path );
+    search_cluster( map, target_cluster, target, true );
+    for ( uint32_t node : clusters_[target_cluster].nodes ) {
+        target_cost[node] = cluster_distance_to( target_cluster, nodes_[node].coords );
+    }
+
+    // A* over the abstract graph
+    struct HeapNode
+    {
+        uint32_t estimate;
+        uint32_t distance;
+        uint32_t node;
+
+        inline bool operator > ( const HeapNode& a ) const noexcept
+        {
+            return estimate != a.estimate ? estimate > a.estimate : distance < a.distance;
+        }
+    };
+
+    const uint32_t min_cost = Map::min_movement_cost();
+    auto heuristic = [&]( const coordinates<size_t>& coords ) -> uint32_t {
+        const size_t dx = coords.x > target.x ? coords.x - target.x : target.x - coords.x;
+        const size_t dy = coords.y > target.y ? coords.y - target.y : target.y - coords.y;
+        return ( dx + dy ) * min_cost;
+    };
+
+    std::vector<uint32_t> distance( nodes_.size() + 2, no_path );
+    std::vector<uint32_t> parent( nodes_.size() + 2, start_node );
+    std::vector<HeapNode> open_list;
+
+    auto relax = [&]( uint32_t from, const Edge& edge ) {
+        const uint32_t new_distance = distance[from] + edge.cost;
+        if ( new_distance >= distance[edge.to] ) return;
+
+        distance[edge.to] = new_distance;
+        parent[edge.to] = from;
+        const uint32_t estimate = new_distance + ( edge.to == target_node ? 0 : heuristic( nodes_[edge.to].coords ) );
+        open_list.push_back( { estimate, new_distance, edge.to } );
+        std::push_heap( open_list.begin(), open_list.end(), std::greater<HeapNode>() );
+    };
+
+    distance[start_node] = 0;
+    for ( const Edge& edge : start_edges ) {
+        relax( start_node, edge );
+    }
+
+    while ( !open_list.empty() ) {
+        std::pop_heap( open_list.begin(), open_list.end(), std::greater<HeapNode>() );
+        const HeapNode current = open_list.back();
+        open_list.pop_back();
+
+        if ( current.distance != distance[current.node] ) continue; // A shorter path was already found to this node
+
+        if ( current.node == target_node ) {
+            std::vector< coordinates<size_t> > waypoints = { target };
+            for ( uint32_t node = parent[target_node]; node != start_node; node = parent[node] ) {
+                // Nodes on the same tile (at the corners of clusters) and nodes on the target or start are skipped
+                if ( nodes_[node].coords != waypoints.back() && nodes_[node].coords != location ) {
+                    waypoints.push_back( nodes_[node].coords );
+                }
+            }
+            std::reverse( waypoints.begin(), waypoints.end() );
+            return waypoints;
+        }
+
+        for ( const Edge& edge : nodes_[current.node].edges ) {
+            relax( current.node, edge );
+        }
+        if ( target_cost[current.node] != no_path ) {
+            relax( current.node, { target_node, target_cost[current.node] } );
+        }
+    }
+
+    // The target was unreachable
+    return {};
+}
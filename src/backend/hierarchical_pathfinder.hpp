@@ -0,0 +1,137 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "coordinates.hpp"
+
+class Map;
+
+
+/**
+ * @brief Hierarchical pathfinding (HPA*) on top of a Map. The map is split into square clusters and the walkable
+ * openings between neighbouring clusters (entrances) become nodes of a small abstract graph. Inside a cluster
+ * the nodes are connected with the cost of the cheapest path between them, so a long path can be searched
+ * on the abstract graph instead of the whole grid and then refined piece by piece on the grid.
+ *
+ * Only the terrain is taken into account, units move every turn so they're left for the grid search to avoid.
+ * The pathfinder doesn't keep a reference to the map, it's passed to every call that needs it. Changing
+ * the terrain of a tile has to be reported with mark_dirty, the affected clusters are then rebuilt
+ * on the next query.
+ */
+class HierarchicalPathfinder
+{
+    public:
+        /**
+         * @brief Builds the abstract graph of the whole map
+         *
+         * @param map the map to build the graph of
+         * @param cluster_size the side length of a cluster in tiles
+         */
+        HierarchicalPathfinder( const Map& map, size_t cluster_size = 16 );
+
+        /**
+         * @brief Marks the cluster containing the tile to be rebuilt on the next query. Called when the terrain of the tile changes.
+         */
+        void mark_dirty( size_t y, size_t x );
+
+        /**
+         * @brief Rebuilds the dirty clusters and the borders around them. Done by find_abstract_path when needed.
+         */
+        void rebuild_dirty( const Map& map );
+
+        /**
+         * @brief Searches the abstract graph for a path from <location> to <target>.
+         *
+         * @return std::vector< coordinates<size_t> > the waypoints of the path in order, not including <location> and
+         * ending with <target>. Consecutive waypoints are in the same cluster, so the grid path between them is short.
+         * Empty if <target> can't be reached or is the same as <location>.
+         */
+        std::vector< coordinates<size_t> > find_abstract_path( const Map& map, const coordinates<size_t>& location, const coordinates<size_t>& target );
+
+        /**
+         * @brief Same as find_abstract_path, but the dirty clusters have to be rebuilt already (see rebuild_dirty).
+         * Only reads the graph, so it can be called from several threads at once.
+         */
+        std::vector< coordinates<size_t> > find_abstract_path( const Map& map, const coordinates<size_t>& location, const coordinates<size_t>& target ) const;
+
+        [[nodiscard]]
+        inline size_t cluster_size() const noexcept
+        {
+            return cluster_size_;
+        }
+
+        /**
+         * @brief The amount of nodes in the abstract graph
+         */
+        [[nodiscard]]
+        size_t node_count() const;
+
+    private:
+        struct Edge
+        {
+            uint32_t to;
+            uint32_t cost;
+        };
+
+        // A tile next to an entrance. Every node has a partner node on the other side of the entrance
+        struct Node
+        {
+            coordinates<size_t> coords;
+            uint32_t cluster;
+            uint32_t partner;
+            std::vector<Edge> edges;
+        };
+
+        struct Cluster
+        {
+            // the tiles of the cluster, the bottom and right bounds are exclusive
+            size_t top;
+            size_t left;
+            size_t bottom;
+            size_t right;
+            bool dirty;
+            std::vector<uint32_t> nodes;
+        };
+
+        // Entrances at least this long get a node at both ends instead of a single one in the middle
+        static const size_t long_entrance_length = 6;
+
+        size_t cluster_size_;
+        size_t cluster_columns_;
+        size_t cluster_rows_;
+        std::vector<Cluster> clusters_;
+        std::vector<Node> nodes_;
+        std::vector<uint32_t> free_nodes_;
+        // The nodes on the borders between clusters. Index cluster * 2 is the border with the cluster on the east
+        // and cluster * 2 + 1 the border with the cluster on the south
+        std::vector< std::vector<uint32_t> > borders_;
+        std::vector<uint32_t> dirty_clusters_;
+
+        // scratch buffer of the searches inside a cluster, one per thread so the searches of different threads don't interfere
+        static std::vector<uint32_t>& cluster_distance();
+
+        [[nodiscard]]
+        inline uint32_t cluster_of( size_t y, size_t x ) const noexcept
+        {
+            return ( y / cluster_size_ ) * cluster_columns_ + x / cluster_size_;
+        }
+
+        uint32_t add_node( const coordinates<size_t>& coords, uint32_t cluster );
+        void remove_node( uint32_t node );
+
+        // removes the nodes of the border and finds its entrances again
+        void build_border( const Map& map, uint32_t cluster, bool south );
+        // recalculates the edges of every node in the cluster
+        void build_edges( const Map& map, uint32_t cluster );
+
+        /*
+         * Dijkstra limited to the tiles of <cluster>, fills cluster_distance() with the cost from <start> to every tile of the cluster.
+         * If <reverse> is true the costs are from every tile to <start> instead, which differ since the cost of a step is the movement cost of the tile stepped on.
+         */
+        void search_cluster( const Map& map, uint32_t cluster, const coordinates<size_t>& start, bool reverse ) const;
+
+        [[nodiscard]]
+        uint32_t cluster_distance_to( uint32_t cluster, const coordinates<size_t>& coords ) const;
+};
@@ -0,0 +1,145 @@
+#include <algorithm>
+#include <cmath>
+
+#include "influence_map.hpp"
+#include "map.hpp"
+#include "unit.hpp"
+#include "team.hpp"
+#include "item.hpp"
+
+
+uint32_t InfluenceMap::reach() {
+    return unit_consts.move_range + unit_consts.visual_range;
+}
+
+
+std::vector<int32_t> InfluenceMap::threat_values( const Unit& unit ) {
+    std::vector<int32_t> values;
+    const std::vector< std::shared_ptr<const Weapon> > weapons = unit.get_weapons();
+    if ( weapons.empty() ) return values;
+
+    values.assign( reach() + 1, 0 );
+    for ( uint32_t distance = 0; distance <= reach(); distance++ ) {
+        // The enemy moves as close as it can first, but can't shoot from the tile itself
+        const int shot_distance = std::max<int>( 1, int( distance ) - int( unit_consts.move_range ) );
+        for ( const std::shared_ptr<const Weapon>& weapon : weapons ) {
+            const int32_t expected = std::lround( weapon->calculate_damage_dealt( shot_distance ) * weapon->get_accuracy() / 100.0 );
+            values[distance] = std::max( values[distance], expected );
+        }
+    }
+    return values;
+}
+
+
+std::vector<int32_t> InfluenceMap::support_values( const Unit& unit ) {
+    std::vector<int32_t> values;
+    const std::vector< std::shared_ptr<const HealingItem> > items = unit.get_healing_items();
+    if ( items.empty() ) return values;
+
+    int32_t heal_amount = 0;
+    for ( const std::shared_ptr<const HealingItem>& item : items ) {
+        heal_amount = std::max( heal_amount, item->get_heal_amount() );
+    }
+
+    values.assign( reach() + 1, 0 );
+    for ( uint32_t distance = 0; distance <= reach(); distance++ ) {
+        values[distance] = heal_amount * int32_t( reach() + 1 - distance ) / int32_t( reach() + 1 );
+    }
+    return values;
+}
+
+
+std::vector<const Item*> InfluenceMap::inventory_of( const Unit& unit ) {
+    std::vector<const Item*> items;
+    for ( const std::shared_ptr<const Item>& item : unit.get_inventory() ) {
+        items.push_back( item.get() );
+    }
+    return items;
+}
+
+
+void InfluenceMap::stamp( const UnitInfluence& influence, int32_t sign ) {
+    if ( influence.values.empty() ) return;
+
+    std::vector<int32_t>& grid = influence.enemy ? threat_ : support_;
+    const int64_t range = influence.values.size() - 1;
+    const int64_t origin_y = influence.location.y;
+    const int64_t origin_x = influence.location.x;
+
+    // The tiles within <range> steps form a diamond, every row of it is clipped to the map
+    for ( int64_t y = std::max<int64_t>( 0, origin_y - range ); y <= std::min<int64_t>( height_ - 1, origin_y + range ); y++ ) {
+        const int64_t dy = y > origin_y ? y - origin_y : origin_y - y;
+        const int64_t left = std::max<int64_t>( 0, origin_x - ( range - dy ) );
+        const int64_t right = std::min<int64_t>( width_ - 1, origin_x + ( range - dy ) );
+        int32_t* row = grid.data() + y * width_;
+        for ( int64_t x = left; x <= right; x++ ) {
+            const int64_t dx = x > origin_x ? x - origin_x : origin_x - x;
+            row[x] += sign * influence.values[dy + dx];
+        }
+    }
+}
+
+
+void InfluenceMap::update( const Map& map, std::vector<Team>& teams, int team_id ) {
+    update_++;
+
+    if ( map.width() != width_ || map.height() != height_ ) {
+        width_ = map.width();
+        height_ = map.height();
+        threat_.assign( width_ * height_, 0 );
+        support_.assign( width_ * height_, 0 );
+        units_.clear();
+        version_++;
+    }
+
+    bool changed = false;
+    for ( Team& team : teams ) {
+        const bool enemy = team.get_id() != team_id;
+        for ( const Unit* unit : team.get_alive_units() ) {
+            const coordinates<size_t> location = map.get_unit_location( unit );
+            auto [it, added] = units_.try_emplace( unit );
+            UnitInfluence& influence = it->second;
+            influence.update = update_;
+
+            const bool items_changed = added || influence.items.size() != unit->get_inventory().size() ||
+                !std::equal( influence.items.begin(), influence.items.end(), unit->get_inventory().begin(),
+                             []( const Item* a, const std::shared_ptr<const Item>& b ) { return a == b.get(); } );
+            if ( !added && !items_changed && influence.location == location && influence.enemy == enemy ) continue;
+
+            // Only the contribution of a unit that was added, moved or changed its items changes
+            if ( !added ) stamp( influence, -1 );
+            influence.location = location;
+            if ( items_changed || influence.enemy != enemy ) {
+                influence.enemy = enemy;
+                influence.values = enemy ? threat_values( *unit ) : support_values( *unit );
+                influence.items = inventory_of( *unit );
+            }
+            stamp( influence, 1 );
+            changed = true;
+        }
+    }
+
+    // Units that died or were removed
+    for ( auto it = units_.begin(); it != units_.end(); ) {
+        if ( it->second.update != update_ ) {
+            stamp( it->second, -1 );
+            it = units_.erase( it );
+            changed = true;
+        } else {
+            ++it;
+        }
+    }
+
+    if ( changed ) version_++;
+}
+
+
+bool InfluenceMap::knows( const Unit* unit ) const {
+    return units_.find( unit ) != units_.end();
+}
+
+
+bool InfluenceMap::is_enemy( const Unit* unit ) const {
+    const auto it = units_.find( unit );
+    return it != units_.end() && it->second.enemy;
+}
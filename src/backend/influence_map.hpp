@@ -0,0 +1,123 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <unordered_map>
+
+#include "coordinates.hpp"
+
+class Map;
+class Unit;
+class Team;
+class Item;
+
+
+/**
+ * @brief Threat and healing support grids of one team, kept up to date incrementally.
+ *
+ * The threat of a tile is the expected damage the enemies of the team could deal to a unit on it next turn: every enemy
+ * can move up to unit_consts.move_range tiles and then shoot with its best weapon, the falloff counted from the end of the
+ * movement. The support of a tile is the healing the team's own healers could give there, full next to the healer and
+ * falling off towards the edge of what the healer reaches in a turn. Walls aren't taken into account, so both are upper
+ * bounds of what can happen.
+ *
+ * Every unit's contribution is stored, so when a unit moves, dies or changes its items only its own contribution is
+ * subtracted and added again. The influence map also remembers which units are enemies, so the AI doesn't have to
+ * look up the team of every unit it sees.
+ */
+class InfluenceMap
+{
+    public:
+        InfluenceMap() = default;
+
+        /**
+         * @brief Brings the grids up to date with the alive units of <teams>. Units that aren't alive in any team anymore
+         * have their contribution removed.
+         *
+         * @param map the map the units are on
+         * @param teams all the teams of the game
+         * @param team_id the team the influence is calculated for, the units of the other teams are its enemies
+         */
+        void update( const Map& map, std::vector<Team>& teams, int team_id );
+
+        /**
+         * @brief The distance (in steps, dx + dy) to which a unit can reach in a turn, the grids are 0 further than this from every unit
+         */
+        static uint32_t reach();
+
+        [[nodiscard]]
+        inline int32_t threat( size_t y, size_t x ) const noexcept
+        {
+            return threat_[y * width_ + x];
+        }
+
+        [[nodiscard]]
+        inline int32_t support( size_t y, size_t x ) const noexcept
+        {
+            return support_[y * width_ + x];
+        }
+
+        /**
+         * @brief The threat of the tile minus its support, the lower the safer it is to end the turn on
+         */
+        [[nodiscard]]
+        inline int32_t danger( const coordinates<size_t>& coords ) const noexcept
+        {
+            const size_t idx = coords.y * width_ + coords.x;
+            return threat_[idx] - support_[idx];
+        }
+
+        /**
+         * @brief True if <unit> was alive in a team the last time the influence map was updated
+         */
+        [[nodiscard]]
+        bool knows( const Unit* unit ) const;
+
+        /**
+         * @brief True if <unit> was in another team than the one the influence is calculated for. False for units it doesn't know.
+         */
+        [[nodiscard]]
+        bool is_enemy( const Unit* unit ) const;
+
+        /**
+         * @brief Incremented every time the grids change
+         */
+        [[nodiscard]]
+        inline size_t version() const noexcept
+        {
+            return version_;
+        }
+
+    private:
+        struct UnitInfluence
+        {
+            coordinates<size_t> location;
+            bool enemy;
+            // the contribution to the threat (enemies) or the support (own team) by the distance from the unit, empty if none
+            std::vector<int32_t> values;
+            // the items the values were calculated from, they're only calculated again when the inventory changes
+            std::vector<const Item*> items;
+            // the update in which the unit was last seen alive
+            size_t update;
+        };
+
+        size_t width_ = 0;
+        size_t height_ = 0;
+        std::vector<int32_t> threat_;
+        std::vector<int32_t> support_;
+        std::unordered_map< const Unit*, UnitInfluence > units_;
+
+        size_t update_ = 0;
+        size_t version_ = 0;
+
+        // the expected damage of the best weapon of <unit> to a tile at each distance
+        static std::vector<int32_t> threat_values( const Unit& unit );
+        // the healing of the best healing item of <unit> to a tile at each distance
+        static std::vector<int32_t> support_values( const Unit& unit );
+
+        static std::vector<const Item*> inventory_of( const Unit& unit );
+
+        // adds (<sign> 1) or subtracts (<sign> -1) the contribution of the unit to its grid
+        void stamp( const UnitInfluence& influence, int32_t sign );
+};
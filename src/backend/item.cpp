@@ -23,10 +23,14 @@ std::shared_ptr<Action> Weapon::get_action(coordinates<size_t> target, Unit& exe
 }
 
 float Weapon::calculate_damage_dealt(int distance) const {
-    double falloff_rate = (100.0 - (double)falloff_) / 100.0;
+    return calculate_damage_dealt(damage_, falloff_, distance);
+}
+
+float Weapon::calculate_damage_dealt(int damage, int falloff, int distance) {
+    double falloff_rate = (100.0 - (double)falloff) / 100.0;
 
     double falloff_effect = std::pow(falloff_rate, (double) distance);
-    int final_dmg = (int)round(damage_ * falloff_effect);
+    int final_dmg = (int)round(damage * falloff_effect);
 
     return final_dmg;
 }
@@ -61,6 +61,9 @@ public:
 
     float calculate_damage_dealt(int distance) const;
 
+    // The damage of a weapon with <damage> and <falloff> at <distance>, for code that only has the numbers of the weapon
+    static float calculate_damage_dealt(int damage, int falloff, int distance);
+
     int get_accuracy() const {
         return accuracy_;
     }
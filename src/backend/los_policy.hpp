@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "bit_grid.hpp"
+
+
+/*
+ * Blocking policies for the line of sight templates of Map. A policy tells from the terrain bit layers of
+ * the map if a tile lets the line of sight through, so the check compiles down to one or two bit tests.
+ * Every policy has its own <id> so the results of different policies can be cached side by side.
+ */
+namespace LosPolicy
+{
+
+// Only terrain that can't be seen through blocks, used for what units see
+struct SeeThrough
+{
+    static constexpr uint8_t id = 0;
+
+    static inline bool transparent( const BitGrid& see_through, const BitGrid& /*shoot_through*/, size_t y, size_t x ) noexcept
+    {
+        return see_through.test( y, x );
+    }
+};
+
+// Only terrain that can't be shot through blocks, used for the area of effect of weapons and healing
+struct ShootThrough
+{
+    static constexpr uint8_t id = 1;
+
+    static inline bool transparent( const BitGrid& /*see_through*/, const BitGrid& shoot_through, size_t y, size_t x ) noexcept
+    {
+        return shoot_through.test( y, x );
+    }
+};
+
+// The tile has to be both seen and shot through, used for the tiles a unit can shoot at
+struct SeeAndShoot
+{
+    static constexpr uint8_t id = 2;
+
+    static inline bool transparent( const BitGrid& see_through, const BitGrid& shoot_through, size_t y, size_t x ) noexcept
+    {
+        return see_through.test( y, x ) && shoot_through.test( y, x );
+    }
+};
+
+} // namespace LosPolicy
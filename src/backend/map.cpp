@@ -16,13 +16,60 @@
 #include "map.hpp"
 #include "helper_tools.hpp"
 
-Map::Map( const size_t width, const size_t height ) : all_terrains_( height, width ), all_units_(height, width), all_buildings_(height, width)
+void Map::SearchBuffers::start_search(size_t tiles) {
+    if (visited_generation.size() < tiles) {
+        visited_generation.resize(tiles, 0);
+        distance.resize(tiles);
+        parent.resize(tiles);
+    }
+
+    // When the generation counter wraps around the old stamps could be mistaken for new ones, so clear them
+    if (++generation == 0) {
+        std::fill(visited_generation.begin(), visited_generation.end(), 0);
+        generation = 1;
+    }
+}
+
+Map::SearchBuffers& Map::search_buffers() {
+    // One set of buffers per thread, so searches on different threads don't interfere with each other
+    thread_local SearchBuffers buffers;
+    return buffers;
+}
+
+const std::array< Map::TerrainProperties, ConstTerrain::terrain_count > Map::terrain_properties_ = []() {
+    std::array< TerrainProperties, ConstTerrain::terrain_count > table;
+    for ( size_t id = 0; id < ConstTerrain::terrain_count; id++ ) {
+        const Terrain& terrain = *ConstTerrain::id_to_terrain[id];
+        table[id] = { 
+            static_cast<uint8_t>( terrain.movement_cost() ), 
+            terrain.can_move_to(), 
+            terrain.can_see_through(), 
+            terrain.can_shoot_through(), 
+            terrain.can_build_on() 
+        };
+    }
+    return table;
+}();
+
+const uint8_t Map::min_movement_cost_ = []() {
+    uint8_t min_cost = std::numeric_limits<uint8_t>::max();
+    for (const TerrainProperties& terrain : terrain_properties_) {
+        if (terrain.can_walk) min_cost = std::min(min_cost, terrain.movement_cost);
+    }
+    return min_cost;
+}();
+
+Map::Map( const size_t width, const size_t height ) : all_terrains_( height, width ), all_units_(height, width),
+    walkable_(height, width), see_through_(height, width), shoot_through_(height, width), occupied_(height, width),
+    region_labels_(height, width)
 {
     this->create_board();
 }
 
 
-Map::Map( const size_t size ) : all_terrains_(size), all_units_(size), all_buildings_(size)
+Map::Map( const size_t size ) : all_terrains_(size), all_units_(size),
+    walkable_(size, size), see_through_(size, size), shoot_through_(size, size), occupied_(size, size),
+    region_labels_(size)
 {
     this->create_board();
 }
@@ -34,11 +81,39 @@ void Map::update_terrain(char terrain, size_t y, size_t x)
     // it can become tedious if we keep adding 
     // different terrains so I used unordered_map for now.
 
-    std::shared_ptr<const Terrain> terrain_ptr = ConstTerrain::get_terrain_from_char(terrain);
-    if (terrain_ptr == nullptr)
+    uint8_t terrain_id = ConstTerrain::get_terrain_id_from_char(terrain);
+    if (terrain_id == ConstTerrain::terrain_count)
         return;
 
-    all_terrains_(y, x) = terrain_ptr;
+    const bool was_walkable = walkable_.test(y, x);
+    all_terrains_(y, x) = terrain_id;
+    terrain_version_++;
+    update_terrain_layers(y, x);
+    if (regions_built_ && was_walkable != walkable_.test(y, x)) {
+        update_regions(y, x);
+    }
+    if (hierarchical_pathfinder_) {
+        hierarchical_pathfinder_->mark_dirty(y, x);
+    }
+}
+
+void Map::enable_hierarchical_pathfinding(size_t cluster_size) {
+    hierarchical_pathfinder_.emplace(*this, cluster_size);
+}
+
+bool Map::hierarchical_pathfinding_enabled() const {
+    return hierarchical_pathfinder_.has_value();
+}
+
+uint8_t Map::min_movement_cost() {
+    return min_movement_cost_;
+}
+
+void Map::update_terrain_layers(size_t y, size_t x) {
+    const TerrainProperties& terrain = properties(y, x);
+    walkable_.assign(y, x, terrain.can_walk);
+    see_through_.assign(y, x, terrain.can_see);
+    shoot_through_.assign(y, x, terrain.can_shoot);
 }
 
 
@@ -50,16 +125,28 @@ void Map::update_terrain(char terrain, const coordinates<size_t>& coords) {
 
 
 
-std::shared_ptr<const Terrain> Map::get_terrain(size_t y, size_t x) 
+const std::shared_ptr<const Terrain>& Map::get_terrain(size_t y, size_t x) const
 {
-    return all_terrains_(y, x);
+    return ConstTerrain::id_to_terrain[ all_terrains_(y, x) ];
 }
 
 
-std::shared_ptr<const Terrain> Map::get_terrain(const coordinates<size_t>& coords) {
+const std::shared_ptr<const Terrain>& Map::get_terrain(const coordinates<size_t>& coords) const {
     return get_terrain(coords.y, coords.x);
 }
 
+uint8_t Map::get_terrain_id(size_t y, size_t x) const {
+    return all_terrains_(y, x);
+}
+
+size_t Map::movement_cost(size_t y, size_t x) const {
+    return properties(y, x).movement_cost;
+}
+
+size_t Map::movement_cost(const coordinates<size_t>& coords) const {
+    return movement_cost(coords.y, coords.x);
+}
+
 bool Map::are_valid_coords(size_t y, size_t x) const {
     return y >= 0 && y < height() && x >= 0 && x < width();
 }
@@ -69,7 +156,7 @@ bool Map::are_valid_coords(const coordinates<size_t> &coords) const {
 }
 
 bool Map::has_building(size_t y, size_t x) const {
-    return all_buildings_(y, x) != nullptr;
+    return building_at_tile_.find(y * width() + x) != building_at_tile_.cend();
 }
 
 
@@ -80,8 +167,10 @@ bool Map::has_building(const coordinates<size_t> &coords) const {
 
 bool Map::add_building(std::shared_ptr<Building> building, size_t y, size_t x) {
     assert(building != nullptr);
-    if (!has_building(y, x) && get_terrain(y, x)->can_build_on()) {
-        all_buildings_(y, x) = building;
+    if (!has_building(y, x) && can_build_on(y, x)) {
+        building_at_tile_[y * width() + x] = buildings_.size();
+        buildings_.push_back({std::move(building), {x, y}});
+        buildings_version_++;
         return true;
     }
 
@@ -94,60 +183,80 @@ bool Map::add_building(std::shared_ptr<Building> building, const coordinates<siz
 }
 
 bool Map::remove_building(size_t y, size_t x) {
-    if (has_building(y, x)) {
-        all_buildings_(y, x) = nullptr;
-        return true;
+    const auto it = building_at_tile_.find(y * width() + x);
+    if (it == building_at_tile_.end()) {
+        return false;
     }
 
-    return false;
+    // Swap the removed entry with the last one so the registry stays dense
+    const size_t idx = it->second;
+    building_at_tile_.erase(it);
+    if (idx != buildings_.size() - 1) {
+        buildings_[idx] = std::move(buildings_.back());
+        const coordinates<size_t>& moved_location = buildings_[idx].location;
+        building_at_tile_[moved_location.y * width() + moved_location.x] = idx;
+    }
+    buildings_.pop_back();
+    buildings_version_++;
+
+    return true;
 }
 
 bool Map::remove_building(const coordinates<size_t> &coords) {
     return remove_building(coords.y, coords.x);
 }
 
-std::shared_ptr<Building> Map::get_building(size_t y, size_t x) {
-    return all_buildings_(y, x);
+std::shared_ptr<Building> Map::get_building(size_t y, size_t x) const {
+    const auto it = building_at_tile_.find(y * width() + x);
+    if (it == building_at_tile_.cend()) {
+        return nullptr;
+    }
+
+    return buildings_[it->second].building;
 }
 
 
-std::shared_ptr<Building> Map::get_building(const coordinates<size_t> &coords) {
+std::shared_ptr<Building> Map::get_building(const coordinates<size_t> &coords) const {
     return get_building(coords.y, coords.x);
 }
 
 std::vector<std::shared_ptr<Building>> Map::get_all_buildings() const {
     std::vector<std::shared_ptr<Building>> out;
-    for (size_t y = 0; y < height(); ++y) {
-        for (size_t x = 0; x < width(); ++x) {
-            std::shared_ptr<Building> b_ptr = all_buildings_(y,x);
-            if (b_ptr != nullptr) {
-                out.push_back(std::move(b_ptr));
-            }
-        }
+    out.reserve(buildings_.size());
+    for (const BuildingEntry& entry : buildings_) {
+        out.push_back(entry.building);
     }
     return out;
 }
 
-bool Map::has_weapon_building(size_t y, size_t x) {
+const std::vector<Map::BuildingEntry>& Map::get_building_entries() const {
+    return buildings_;
+}
+
+size_t Map::buildings_version() const {
+    return buildings_version_;
+}
+
+bool Map::has_weapon_building(size_t y, size_t x) const {
     const std::shared_ptr<Building>& building = get_building(y, x);
     return building != nullptr && building->get_item()->is_weapon();
 }
 
-bool Map::has_weapon_building(const coordinates<size_t>& coords) {
+bool Map::has_weapon_building(const coordinates<size_t>& coords) const {
     return has_weapon_building(coords.y, coords.x);
 }
 
-bool Map::has_healing_building(size_t y, size_t x) {
+bool Map::has_healing_building(size_t y, size_t x) const {
     const std::shared_ptr<Building>& building = get_building(y, x);
     return building != nullptr && building->get_item()->is_healing_item();
 }
 
-bool Map::has_healing_building(const coordinates<size_t>& coords) {
+bool Map::has_healing_building(const coordinates<size_t>& coords) const {
     return has_healing_building(coords.y, coords.x);
 }
 
 bool Map::can_build_on(size_t y, size_t x) const {
-    return all_terrains_(y, x)->can_build_on();
+    return properties(y, x).can_build;
 }
 
 
@@ -156,26 +265,32 @@ bool Map::can_build_on(const coordinates<size_t> &coords) const {
 }
 
 bool Map::can_move_to_terrain(size_t y, size_t x) const {
-    return all_terrains_(y, x)->can_move_to();
+    return walkable_.test(y, x);
 }
 bool Map::can_move_to_terrain(const coordinates<size_t> &coords) const {
     return can_move_to_terrain(coords.y, coords.x);
 }
 
 bool Map::can_move_to_coords(size_t y, size_t x) const {
-    return can_move_to_terrain(y, x) && (!has_unit(y, x));
+    return walkable_.test(y, x) && !occupied_.test(y, x);
 }
 bool Map::can_move_to_coords(const coordinates<size_t> coords) const {
     return can_move_to_coords(coords.y, coords.x);
 }
 
 bool Map::has_unit(size_t y, size_t x) const {
-    return all_units_(y, x) != nullptr;
+    return occupied_.test(y, x);
 }
 bool Map::has_unit(const coordinates<size_t>& coords) const {
     return has_unit(coords.y, coords.x);
 }
 
+BitGrid Map::free_tiles_layer() const {
+    BitGrid free_tiles(height(), width());
+    BitGrid::and_not(walkable_, occupied_, free_tiles);
+    return free_tiles;
+}
+
 
 bool Map::add_unit(size_t y, size_t x, Unit* unit) {
     if (has_unit(y, x) || !can_move_to_terrain(y, x)) {
@@ -183,6 +298,8 @@ bool Map::add_unit(size_t y, size_t x, Unit* unit) {
     }
 
     all_units_(y, x) = unit;
+    occupied_.set(y, x);
+    unit_locations_[unit] = {x, y};
     return true;
 }
 
@@ -190,23 +307,20 @@ bool Map::add_unit(const coordinates<size_t>& coords, Unit* unit) {
     return add_unit(coords.y, coords.x, unit);
 }
 
-Unit* Map::get_unit(size_t y, size_t x) {
+Unit* Map::get_unit(size_t y, size_t x) const {
     return all_units_(y, x);
 }
 
-Unit* Map::get_unit(const coordinates<size_t>& coords) {
+Unit* Map::get_unit(const coordinates<size_t>& coords) const {
     return get_unit(coords.y, coords.x);
 }
 
-coordinates<size_t> Map::get_unit_location(Unit *unit_ptr) const {
+coordinates<size_t> Map::get_unit_location(const Unit *unit_ptr) const {
     assert(unit_ptr != nullptr);
 
-    for (size_t y = 0; y < height(); ++y) {
-        for (size_t x = 0; x < width(); ++x) {
-            if (all_units_(y, x) == unit_ptr) {
-                return {x, y};
-            }
-        }
+    const auto it = unit_locations_.find(unit_ptr);
+    if (it != unit_locations_.cend()) {
+        return it->second;
     }
 
     assert(false && "The specified unit does not exist in this map");
@@ -216,11 +330,9 @@ coordinates<size_t> Map::get_unit_location(Unit *unit_ptr) const {
 coordinates<size_t> Map::get_building_location(std::shared_ptr<Building> building_ptr) const {
     assert(building_ptr != nullptr);
 
-    for (size_t y = 0; y < height(); ++y) {
-        for (size_t x = 0; x < width(); ++x) {
-            if (all_buildings_(y, x) == building_ptr) {
-                return {x, y};
-            }
+    for (const BuildingEntry& entry : buildings_) {
+        if (entry.building == building_ptr) {
+            return entry.location;
         }
     }
 
@@ -230,7 +342,14 @@ coordinates<size_t> Map::get_building_location(std::shared_ptr<Building> buildin
 
 bool Map::remove_unit(size_t y, size_t x){
     if (has_unit(y, x)) {
+        // Only forget the unit's location if the index points to these coordinates,
+        // the same unit could have been added to more than one tile
+        const auto it = unit_locations_.find(all_units_(y, x));
+        if (it != unit_locations_.end() && it->second == coordinates<size_t>{x, y}) {
+            unit_locations_.erase(it);
+        }
         all_units_(y, x) = nullptr;
+        occupied_.reset(y, x);
         return true;
     }
     return false;
@@ -250,7 +369,10 @@ bool Map::move_unit(size_t origin_y, size_t origin_x, size_t dest_y, size_t dest
     //Move unit to destination and remove from origin
     Unit* origin_unit = get_unit(origin_y, origin_x);
     all_units_(dest_y, dest_x) = origin_unit;
-    remove_unit(origin_y, origin_x);
+    all_units_(origin_y, origin_x) = nullptr;
+    occupied_.set(dest_y, dest_x);
+    occupied_.reset(origin_y, origin_x);
+    unit_locations_[origin_unit] = {dest_x, dest_y};
 
     return true;
 }
@@ -260,16 +382,14 @@ bool Map::move_unit(const coordinates<size_t>& origin, const coordinates<size_t>
 }
 
 
-constexpr inline void Map::create_board() noexcept
+inline void Map::create_board() noexcept
 {
     // with this nested loop we create all the Terrains
     for ( size_t y = 0; y < height(); y++ ) {
         for ( size_t x = 0; x < width(); x++ ) {
 
-            // here we use normal initialisation because if we use std::make_shared the objects
-            // wont be deleted until all the weak pointers go out of scope.
-            // Because I use std::weak_ptr's in Terrain, I cannot use std::make_shared
-            all_terrains_(y, x) = ConstTerrain::background;
+            all_terrains_(y, x) = ConstTerrain::background_id;
+            update_terrain_layers(y, x);
 
         }
     }
@@ -287,25 +407,25 @@ std::shared_ptr<const Terrain> Map::get_neighbor( const coordinates<size_t>& loc
     switch ( direction ) {
         case Helper::Directions::North:
             if ( location.y > 0 ) {
-                possible_location = this->all_terrains_( location.x, location.y - 1 );
+                possible_location = ConstTerrain::id_to_terrain[ this->all_terrains_( location.x, location.y - 1 ) ];
             }
             break;
 
         case Helper::Directions::East:
             if ( location.x < width() - 1) {
-                possible_location = this->all_terrains_( location.x + 1, location.y );
+                possible_location = ConstTerrain::id_to_terrain[ this->all_terrains_( location.x + 1, location.y ) ];
             }
             break;
 
         case Helper::Directions::South:
             if ( location.y < height() - 1 ) {
-                possible_location = this->all_terrains_( location.x, location.y + 1 );
+                possible_location = ConstTerrain::id_to_terrain[ this->all_terrains_( location.x, location.y + 1 ) ];
             }
             break;
 
         case Helper::Directions::West:
             if ( location.x > 0 ) {
-                possible_location = this->all_terrains_( location.x - 1, location.y );
+                possible_location = ConstTerrain::id_to_terrain[ this->all_terrains_( location.x - 1, location.y ) ];
             }
             break;
     }
@@ -340,6 +460,16 @@ std::vector< coordinates<size_t> > Map::max_visible_locations( const coordinates
 
     size_t x = location.x;
     size_t y = location.y; 
+
+    if ( visibility_range <= RangeTables::max_range ) {
+        const RangeTables::Ring& ring = RangeTables::rings[ visibility_range ];
+        visible_tiles.reserve( ring.size );
+        for ( size_t i = 0; i < ring.size; i++ ) {
+            visible_tiles.emplace_back( x + ring.offsets[i].dx, y + ring.offsets[i].dy );
+        }
+        return visible_tiles;
+    }
+
     uint32_t d = visibility_range - 1;
     uint32_t a = visibility_range - 1;
     uint32_t b = 0;
@@ -373,120 +503,24 @@ std::vector< coordinates<size_t> > Map::max_visible_locations( const coordinates
 }
 
 std::vector<coordinates<size_t>> Map::tiles_can_shoot_on(const coordinates<size_t>& coords, const uint32_t range) {
-    return line_of_sight_check(coords, range + 1, [this](int64_t y, int64_t x) -> bool {
-        const std::shared_ptr<const Terrain>& terrain = this->get_terrain(y, x);
-        return terrain->can_shoot_through() && terrain->can_see_through();
-    });
+    return line_of_sight_check<LosPolicy::SeeAndShoot>(coords, range);
 }
 
-std::vector< coordinates<size_t> > Map::tiles_unit_sees( const coordinates<size_t>& location, const uint32_t visibility_range )
+std::vector< coordinates<size_t> > Map::tiles_unit_sees( const coordinates<size_t>& location, const uint32_t visibility_range ) const
 {
-    return line_of_sight_check(location, visibility_range + 1, [this](int64_t y, int64_t x) -> bool {
-        return this->get_terrain(y, x)->can_see_through();
-    });
+    return line_of_sight_check<LosPolicy::SeeThrough>(location, visibility_range);
 }
 
 std::vector<coordinates<size_t>> Map::get_aoe_affected_coords(const coordinates<size_t>& location, const uint32_t range) {
-    return line_of_sight_check(location, range + 1, [this](int64_t y, int64_t x) -> bool {
-        return this->get_terrain(y, x)->can_shoot_through();
-    });
+    return line_of_sight_check<LosPolicy::ShootThrough>(location, range);
 }
 
-bool Map::los_check_from_A_to_B(const coordinates<size_t>& a, const coordinates<size_t>& b, const uint32_t range) {
-    auto los_tiles = line_of_sight_check(a,range + 1,[this](int64_t y, int64_t x) -> bool {
-        return this->get_terrain(y, x)->can_shoot_through();
-    });
-    auto coord_it = std::find(los_tiles.begin(),los_tiles.end(),b);
-    return coord_it != los_tiles.end();
+std::vector<coordinates<size_t>> Map::get_aoe_affected_unit_coords(const coordinates<size_t>& location, const uint32_t range) const {
+    return units_in_sight<LosPolicy::ShootThrough>(location, range);
 }
 
-std::vector< coordinates<size_t> > Map::line_of_sight_check( const coordinates<size_t>& location, const uint32_t range, const std::function<bool(int64_t y, int64_t x)>& predicate) {
-    std::vector< coordinates<size_t> > max_range_coords = max_visible_locations( location, range );
-    std::vector< coordinates<size_t> > max_range_coords1 = max_visible_locations( location, range - 1 ); // used to fix the error where there would be left some holes in the circle
-
-    // add the smaller circle into the bigger one to fix the error, 
-    // the formula should've accounted for this but apparently it did not.
-    max_range_coords.insert( max_range_coords.end(), max_range_coords1.begin(), max_range_coords1.end() );
-
-
-    // Set to avoid duplicate coordinates and size is small enough that insert time is okay
-    std::set< coordinates<size_t> > visible_coords = { {location.x, location.y} }; // contains the starting location
-
-    // this utilises Bresentham's line drawing algorithm which is 
-    // modified to work on all directions
-    int64_t x0 = location.x;
-    int64_t y0 = location.y;
-    int64_t x1 = 0;
-    int64_t y1 = 0;
-
-    int64_t dx = 0;
-    int64_t sx = 0;
-    int64_t dy = 0;
-    int64_t sy = 0;
-    int64_t error = 0;
-    int64_t e2 = 0;
-
-    for ( const coordinates<size_t>& a_side : max_range_coords ) {
-        x0 = location.x;
-        y0 = location.y;
-
-        x1 = a_side.x;
-        y1 = a_side.y;
-        
-        dx = std::abs( x1 - x0 );
-        sx = ( x0 < x1 ) ? 1 : -1;
-        dy = (-1) * std::abs( y1 - y0 );
-        sy = ( y0 < y1 ) ? 1 : -1;
-        error = dx + dy;
-
-        while ( true ) {
-
-            if ( x0 == x1 && y0 == y1 ) {
-                break;
-            }
-            
-            
-
-            e2 = 2 * error;
-
-            if ( e2 >= dy ) {
-                error += dy;
-                x0 += sx;
-            }
-            if ( e2 <= dx ) {
-                error += dx;
-                y0 += sy;
-            }
-
-
-            // check that the tile that we're trying to look for is not out of range,
-            // this can happen if the <location + visibility_range> is more than the map width or length or less than 0.
-            if ( y0 < 0 || y0 >= height() || x0 < 0 || x0 >= width() ) {
-                break;
-            }
-            // check that you can see through the tile, if not, then we stop looping since we also cant see the following tiles
-            if (predicate(y0, x0) == false) {
-                visible_coords.emplace(x0, y0);
-                break;
-            }
-            // this is for the special case that if there's a corner in which the absolute corner tile is visible but the ones next to it are not,
-            // we have to check for this case in both y and x axis.
-            // if ( get_terrain( Helper::clamp( y0 - sy, 0, height() - 1 ), x0)->can_see_through() == false 
-            //     && get_terrain( y0, Helper::clamp( x0 - sx, 0, width() - 1) )->can_see_through() == false) {
-            //     break;
-            // }
-            if (predicate(Helper::clamp(y0 - sy, 0, height() - 1), x0) == false &&
-                predicate(y0, Helper::clamp(x0 - sx, 0, width() - 1)) == false) {
-                break;
-            }
-            
-            visible_coords.emplace( x0, y0 );
-        }
-    }
-
-    //return result as a vector using vectors constructor that takes iterators
-    return {visible_coords.begin(), visible_coords.end()};
-
+bool Map::los_check_from_A_to_B(const coordinates<size_t>& a, const coordinates<size_t>& b, const uint32_t range) const {
+    return has_line_of_sight<LosPolicy::ShootThrough>(a, b, range);
 }
 
 std::vector< coordinates<size_t> > Map::get_neighbouring_coordinates( const coordinates<size_t>& location )
@@ -606,7 +640,7 @@ std::vector< coordinates<size_t> > Map::possible_tiles_to_move_to( const coordin
 
                 // check if we've already processed the tile
                 if ( !(is_processed[ aux.y * width() + aux.x ] )) {   
-                    Relax( curr, aux, all_terrains_( aux.y, aux.x )->movement_cost() );
+                    Relax( curr, aux, properties( aux.y, aux.x ).movement_cost );
 
                     distances.emplace( vertex_attributes( aux.y, aux.x ).first, aux );
                 }
@@ -623,190 +657,375 @@ std::vector< coordinates<size_t> > Map::possible_tiles_to_move_to( const coordin
 }
 
 
-std::vector< coordinates< size_t > > Map::possible_tiles_to_move_to3( const coordinates<size_t>& location, uint8_t movement_range ) {
+std::vector< coordinates< size_t > > Map::possible_tiles_to_move_to3( const coordinates<size_t>& location, uint8_t movement_range ) const {
     // Timer timer;
-    struct Vertex {
-        size_t cooldown;
-        coordinates<size_t> coords;
-    };
-
-    std::vector<bool> visited(width() * height(), false);
+    // Dial's algorithm: the movement costs are small integers, so instead of a priority queue the tiles are put
+    // into buckets by their distance from <location> and the buckets are processed in order of distance.
+    // A tile can be put into a bucket more than once if a shorter path to it is found later, the outdated entries are skipped.
+    SearchBuffers& buffers = search_buffers();
+    buffers.start_search(width() * height());
+
+    std::vector<std::vector<uint32_t>>& buckets = buffers.buckets;
+    if (buckets.size() < size_t(movement_range) + 1) {
+        buckets.resize(size_t(movement_range) + 1);
+    }
 
     std::vector<coordinates<size_t>> result;
-    // Don't add starting location to result
-    visited[location.y * width() + location.x] = true;
-
-    // Queue of vertices that will be visited in the search.
-    std::deque<Vertex> vertex_queue;
-    // List of vertices that have a movement cost greater than 1 and thus won't be searched until that many movements have been used
-    std::list<Vertex> waiting_vertices;
-
-    // Add starting location to queue and mark it as visited
-    vertex_queue.emplace_back(0, location);
-    visited[location.y * width() + location.x] = true;
-    uint8_t movements_left = movement_range;
-
-    while (movements_left > 0) {
-        // Store how many tiles to visit in this movement
-        int current_size = vertex_queue.size();
-    
-        for (int i = 0; i < current_size; i++) {
-            const Vertex& current_vertex = vertex_queue.front();
-
-            std::vector<coordinates<size_t>> neighbours = get_neighbouring_coordinates(current_vertex.coords);
-            for (const auto& neighbour : neighbours) {
-                // Get this neighbour's terrain, check if the neighbour was already visited or if you can move to it.
-                // If visited or can't move, skip it, otherwise visit it and mark it as visited
-                const std::shared_ptr<const Terrain>& neighbour_terrain = all_terrains_[neighbour];
-                if (visited[neighbour.y * width() + neighbour.x]|| !can_move_to_coords(neighbour)) continue;
-                visited[neighbour.y * width() + neighbour.x] = true;
-
-                // If it costs only 1 movement action to move into this tile, add it to the queue straight away.
-                // Otherwise add it to waiting_vertices
-                if (neighbour_terrain->movement_cost() > 1) {
-                    waiting_vertices.emplace_back(neighbour_terrain->movement_cost(), neighbour);
-                } else {
-                    vertex_queue.emplace_back(0, neighbour);
-                    result.push_back(neighbour);
-                }
-            }
-            vertex_queue.pop_front();
-        }
-        
-        // Loop through waiting vertices, decrease each vertex's cooldown and if it reaches 0, remove it from waiting_vertices
-        // and add it to the queue of vertices to visit on the next movement
-        auto it = waiting_vertices.begin();
-        while (it != waiting_vertices.end()) {
-            auto waiting_vertex_it = it++;
-            Vertex& waiting_vertex = *waiting_vertex_it;
-            if (--waiting_vertex.cooldown <= 0) {
-                result.push_back(waiting_vertex.coords);
-                vertex_queue.push_back(std::move(waiting_vertex));
-                waiting_vertices.erase(waiting_vertex_it);
+
+    const uint32_t start_idx = location.y * width() + location.x;
+    buffers.visit(start_idx, 0);
+    buckets[0].push_back(start_idx);
+
+    for (uint32_t distance = 0; distance <= movement_range; distance++) {
+        // Movement costs are at least 1, so this bucket doesn't grow while it's processed
+        for (uint32_t idx : buckets[distance]) {
+            if (buffers.distance[idx] != distance) continue; // A shorter path was already found to this tile
+
+            const size_t y = idx / width();
+            const size_t x = idx % width();
+            // Don't add starting location to result
+            if (idx != start_idx) {
+                result.emplace_back(x, y);
             }
+
+            for_each_neighbour(y, x, [&](size_t n_y, size_t n_x) {
+                if (!can_move_to_coords(n_y, n_x)) return;
+
+                const uint32_t neighbour_idx = n_y * width() + n_x;
+                const uint32_t neighbour_distance = distance + properties(n_y, n_x).movement_cost;
+                if (neighbour_distance > movement_range) return;
+
+                if (!buffers.visited(neighbour_idx) || neighbour_distance < buffers.distance[neighbour_idx]) {
+                    buffers.visit(neighbour_idx, neighbour_distance);
+                    buckets[neighbour_distance].push_back(neighbour_idx);
+                }
+            });
         }
-        movements_left--;
+        buckets[distance].clear();
     }
 
     return result;
 }
 
-coordinates<size_t> Map::get_closest_accessible_tile(const coordinates<size_t>& location) {
+coordinates<size_t> Map::get_closest_accessible_tile(const coordinates<size_t>& location, uint32_t region) const {
+    // Every tile is put into the queue only once, so the search stops after the whole map has been searched at the latest
+    SearchBuffers& buffers = search_buffers();
+    buffers.start_search(width() * height());
+
     std::deque<coordinates<size_t>> q;
     q.push_back(location);
-    std::vector<bool> visited(width() * height(), false);
+    buffers.visit(location.y * width() + location.x, 0);
 
     while (!q.empty()) {
         coordinates<size_t> current = q.front();
         q.pop_front();
 
-        if (can_move_to_coords(current))
+        if (can_move_to_coords(current) && (region == 0 || region_of(current) == region))
             return current;
 
-        for (const coordinates<size_t>& neighbour : get_neighbouring_coordinates(current)) {
-            q.push_back(neighbour);
+        for_each_neighbour(current.y, current.x, [&](size_t n_y, size_t n_x) {
+            const uint32_t neighbour_idx = n_y * width() + n_x;
+            if (buffers.visited(neighbour_idx)) return;
+
+            buffers.visit(neighbour_idx, 0);
+            q.emplace_back(n_x, n_y);
+        });
+    }
+
+    assert(region != 0 && "There is not a single tile on the map that you can move to");
+
+    return location;
+}
+
+uint32_t Map::new_region_label() {
+    if (!free_region_labels_.empty()) {
+        uint32_t label = free_region_labels_.back();
+        free_region_labels_.pop_back();
+        return label;
+    }
+    region_sizes_.push_back(0);
+    return region_sizes_.size() - 1;
+}
+
+size_t Map::relabel_region(size_t y, size_t x, uint32_t from, uint32_t to) {
+    std::vector<uint32_t> stack = { static_cast<uint32_t>(y * width() + x) };
+    region_labels_(y, x) = to;
+    size_t count = 0;
+
+    while (!stack.empty()) {
+        const uint32_t idx = stack.back();
+        stack.pop_back();
+        count++;
+
+        for_each_neighbour(idx / width(), idx % width(), [&](size_t n_y, size_t n_x) {
+            if (!walkable_.test(n_y, n_x) || region_labels_(n_y, n_x) != from) return;
+
+            region_labels_(n_y, n_x) = to;
+            stack.push_back(n_y * width() + n_x);
+        });
+    }
+
+    return count;
+}
+
+void Map::build_regions() {
+    // Label 0 is reserved for the tiles that can't be walked on
+    region_sizes_.assign(1, 0);
+    free_region_labels_.clear();
+    for (size_t y = 0; y < height(); y++) {
+        for (size_t x = 0; x < width(); x++) {
+            region_labels_(y, x) = 0;
         }
+    }
 
+    for (size_t y = 0; y < height(); y++) {
+        for (size_t x = 0; x < width(); x++) {
+            if (walkable_.test(y, x) && region_labels_(y, x) == 0) {
+                const uint32_t label = new_region_label();
+                region_sizes_[label] = relabel_region(y, x, 0, label);
+            }
+        }
     }
+    regions_built_ = true;
+}
 
-    assert(false && "There is not a single tile on the map that you can move to");
+void Map::update_regions(size_t y, size_t x) {
+    if (walkable_.test(y, x)) {
+        // The tile joins the regions around it. The largest one keeps its label and the others are relabeled to it
+        uint32_t largest = 0;
+        for_each_neighbour(y, x, [&](size_t n_y, size_t n_x) {
+            const uint32_t label = region_labels_(n_y, n_x);
+            if (label != 0 && (largest == 0 || region_sizes_[label] > region_sizes_[largest])) largest = label;
+        });
+
+        if (largest == 0) {
+            largest = new_region_label();
+        }
+        region_labels_(y, x) = largest;
+        region_sizes_[largest]++;
 
-    return {0, 0};
+        for_each_neighbour(y, x, [&](size_t n_y, size_t n_x) {
+            const uint32_t label = region_labels_(n_y, n_x);
+            if (label == 0 || label == largest) return;
+
+            region_sizes_[largest] += relabel_region(n_y, n_x, label, largest);
+            region_sizes_[label] = 0;
+            free_region_labels_.push_back(label);
+        });
+        return;
+    }
+
+    const uint32_t old_label = region_labels_(y, x);
+    region_labels_(y, x) = 0;
+    region_sizes_[old_label]--;
+
+    // The region can only split if the walkable neighbours aren't connected to each other around the tile. Going around
+    // the 8 tiles surrounding it, neighbours in the same run of walkable tiles are connected.
+    const int32_t ring_dy[] = {-1, -1, 0, 1, 1, 1, 0, -1};
+    const int32_t ring_dx[] = {0, 1, 1, 1, 0, -1, -1, -1};
+    auto ring_walkable = [&](int i) {
+        const size_t r_y = y + ring_dy[i % 8];
+        const size_t r_x = x + ring_dx[i % 8];
+        return r_y < height() && r_x < width() && walkable_.test(r_y, r_x);
+    };
+
+    // Start from a tile that isn't walkable so runs don't wrap around the start
+    int start = 0;
+    while (start < 8 && ring_walkable(start)) start++;
+    if (start == 8) return; // Every surrounding tile is walkable
+
+    int runs_with_neighbours = 0;
+    bool run_has_neighbour = false;
+    for (int i = start + 1; i <= start + 8; i++) {
+        if (ring_walkable(i)) {
+            // Even positions of the ring are the 4 neighbours
+            run_has_neighbour |= (i % 2 == 0);
+        } else if (run_has_neighbour) {
+            runs_with_neighbours++;
+            run_has_neighbour = false;
+        }
+    }
+
+    if (region_sizes_[old_label] == 0) {
+        free_region_labels_.push_back(old_label);
+        return;
+    }
+    if (runs_with_neighbours <= 1) return;
+
+    // The region might have been split, every neighbour that still has the old label is flooded with a new label.
+    // If the neighbours were still connected further away, the first flood takes the whole region and the old label is freed.
+    bool first = true;
+    for_each_neighbour(y, x, [&](size_t n_y, size_t n_x) {
+        if (region_labels_(n_y, n_x) != old_label) return;
+        if (first) {
+            first = false;
+            return;
+        }
+
+        const uint32_t label = new_region_label();
+        region_sizes_[label] = relabel_region(n_y, n_x, old_label, label);
+        region_sizes_[old_label] -= region_sizes_[label];
+    });
+
+    if (region_sizes_[old_label] == 0) {
+        free_region_labels_.push_back(old_label);
+    }
 }
 
-coordinates<size_t> Map::fastest_movement_to_target(const coordinates<size_t>& location, coordinates<size_t> target, uint8_t movement_range) {
+uint32_t Map::region_of(size_t y, size_t x) {
+    if (!regions_built_) {
+        build_regions();
+    }
+    return region_labels_(y, x);
+}
+
+uint32_t Map::region_of(const coordinates<size_t>& coords) {
+    return region_of(coords.y, coords.x);
+}
+
+uint32_t Map::region_of(size_t y, size_t x) const {
+    assert(regions_built_ && "The regions have to be built with prepare_searches first");
+    return region_labels_(y, x);
+}
+
+uint32_t Map::region_of(const coordinates<size_t>& coords) const {
+    return region_of(coords.y, coords.x);
+}
+
+void Map::prepare_searches() {
+    if (!regions_built_) {
+        build_regions();
+    }
+    if (hierarchical_pathfinder_) {
+        hierarchical_pathfinder_->rebuild_dirty(*this);
+    }
+}
+
+bool Map::are_connected(const coordinates<size_t>& a, const coordinates<size_t>& b) {
+    const uint32_t region = region_of(a);
+    return region != 0 && region == region_of(b);
+}
+
+std::vector<coordinates<size_t>> Map::find_path(const coordinates<size_t>& location, const coordinates<size_t>& target) const {
     // Timer timer;
-    struct Vertex {
-        size_t cooldown;
-        coordinates<size_t> coords;
-    };
+    // A* search, the heuristic is the manhattan distance scaled by the cheapest movement cost so it never overestimates.
+    // The open list is a binary heap that can contain outdated entries, those are skipped when popped.
+    using HeapNode = SearchBuffers::HeapNode;
 
-    assert(can_move_to_terrain(target) && "Target coordinates cannot be moved to");
-    if (has_unit(target)) {
-        target = get_closest_accessible_tile(target);
+    if (location == target || !can_move_to_coords(target)) {
+        return {};
     }
 
-    std::vector<bool> visited(width() * height(), false);
-    Matrix<coordinates<size_t>> parents(width() * height());
-    parents(location) = location;
+    SearchBuffers& buffers = search_buffers();
+    buffers.start_search(width() * height());
 
-    // Queue of vertices that will be visited in the search.
-    std::deque<Vertex> vertex_queue;
-    // List of vertices that have a movement cost greater than 1 and thus won't be searched until that many movements have been used
-    std::list<Vertex> waiting_vertices;
+    auto heuristic = [&target](size_t y, size_t x) -> uint32_t {
+        const size_t dx = x > target.x ? x - target.x : target.x - x;
+        const size_t dy = y > target.y ? y - target.y : target.y - y;
+        return (dx + dy) * min_movement_cost_;
+    };
 
-    // Add starting location to queue and mark it as visited
-    vertex_queue.emplace_back(0, location);
-    visited[location.y * width() + location.x] = true;
-    uint8_t movements_left = movement_range;
+    std::vector<HeapNode>& open_list = buffers.open_list;
+    open_list.clear();
 
-    while (!vertex_queue.empty()) {
-        // Store how many tiles to visit in this movement
-        int current_size = vertex_queue.size();
-    
-        for (int i = 0; i < current_size; i++) {
-            const Vertex& current_vertex = vertex_queue.front();
-
-            std::vector<coordinates<size_t>> neighbours = get_neighbouring_coordinates(current_vertex.coords);
-            for (const auto& neighbour : neighbours) {
-                // Get this neighbour's terrain, check if the neighbour was already visited or if you can move to it.
-                // If visited or can't move, skip it, otherwise visit it and mark it as visited
-                const std::shared_ptr<const Terrain>& neighbour_terrain = all_terrains_[neighbour];
-                if (visited[neighbour.y * width() + neighbour.x]|| !can_move_to_coords(neighbour)) continue;
-                visited[neighbour.y * width() + neighbour.x] = true;
-                parents(neighbour) = current_vertex.coords;
-
-                if (neighbour == target) { //Found target, backtrack and create a path
-                    std::vector<coordinates<size_t>> path;
-                    coordinates<size_t> current = neighbour;
-
-                    while (current != location) { //Loop until we're at the starting location
-                        path.push_back(current);
-                        current = parents(current);
-                    }
-
-                    size_t i = path.size();
-                    int range_left = movement_range;
-                    while (i > 0) {
-                        i--;
-                        range_left -= all_terrains_(path[i])->movement_cost();
-
-                        // If no move range to move or this is the last coordinate in the path, return
-                        if (range_left <= 0 || i == 0) {
-                            return path[i];
-                        }
-
-                    }
+    const uint32_t start_idx = location.y * width() + location.x;
+    const uint32_t target_idx = target.y * width() + target.x;
+    buffers.visit(start_idx, 0);
+    buffers.parent[start_idx] = start_idx;
+    open_list.push_back({heuristic(location.y, location.x), 0, start_idx});
 
-                }
+    while (!open_list.empty()) {
+        std::pop_heap(open_list.begin(), open_list.end(), std::greater<HeapNode>());
+        const HeapNode current = open_list.back();
+        open_list.pop_back();
 
-                // If it costs only 1 movement action to move into this tile, add it to the queue straight away.
-                // Otherwise add it to waiting_vertices
-                if (neighbour_terrain->movement_cost() > 1) {
-                    waiting_vertices.emplace_back(neighbour_terrain->movement_cost(), neighbour);
-                } else {
-                    vertex_queue.emplace_back(0, neighbour);
-                }
+        if (current.distance != buffers.distance[current.idx]) continue; // A shorter path was already found to this tile
+
+        if (current.idx == target_idx) { //Found target, backtrack and create a path
+            std::vector<coordinates<size_t>> path;
+            for (uint32_t idx = target_idx; idx != start_idx; idx = buffers.parent[idx]) {
+                path.emplace_back(idx % width(), idx / width());
             }
-            vertex_queue.pop_front();
+            std::reverse(path.begin(), path.end());
+            return path;
         }
-        
-        // Loop through waiting vertices, decrease each vertex's cooldown and if it reaches 0, remove it from waiting_vertices
-        // and add it to the queue of vertices to visit on the next movement
-        auto it = waiting_vertices.begin();
-        while (it != waiting_vertices.end()) {
-            auto waiting_vertex_it = it++;
-            Vertex& waiting_vertex = *waiting_vertex_it;
-            if (--waiting_vertex.cooldown <= 0) {
-                vertex_queue.push_back(std::move(waiting_vertex));
-                waiting_vertices.erase(waiting_vertex_it);
+
+        for_each_neighbour(current.idx / width(), current.idx % width(), [&](size_t n_y, size_t n_x) {
+            if (!can_move_to_coords(n_y, n_x)) return;
+
+            const uint32_t neighbour_idx = n_y * width() + n_x;
+            const uint32_t neighbour_distance = current.distance + properties(n_y, n_x).movement_cost;
+
+            if (!buffers.visited(neighbour_idx) || neighbour_distance < buffers.distance[neighbour_idx]) {
+                buffers.visit(neighbour_idx, neighbour_distance);
+                buffers.parent[neighbour_idx] = current.idx;
+                open_list.push_back({neighbour_distance + heuristic(n_y, n_x), neighbour_distance, neighbour_idx});
+                std::push_heap(open_list.begin(), open_list.end(), std::greater<HeapNode>());
+            }
+        });
+    }
+
+    // The target was unreachable
+    return {};
+}
+
+coordinates<size_t> Map::fastest_movement_to_target(const coordinates<size_t>& location, coordinates<size_t> target, uint8_t movement_range) {
+    prepare_searches();
+    return std::as_const(*this).fastest_movement_to_target(location, target, movement_range);
+}
+
+coordinates<size_t> Map::fastest_movement_to_target(const coordinates<size_t>& location, coordinates<size_t> target, uint8_t movement_range) const {
+    assert(can_move_to_terrain(target) && "Target coordinates cannot be moved to");
+    // Only tiles in the unit's own region can be reached, so the target is replaced with the closest free one in it
+    const uint32_t region = region_of(location);
+    if (has_unit(target)) {
+        target = get_closest_accessible_tile(target, region);
+    }
+    if (region_of(target) != region || !can_move_to_coords(target)) {
+        return location;
+    }
+
+    std::vector<coordinates<size_t>> path;
+    const size_t distance = (location.x > target.x ? location.x - target.x : target.x - location.x)
+                          + (location.y > target.y ? location.y - target.y : target.y - location.y);
+
+    if (hierarchical_pathfinder_ && distance > 2 * hierarchical_pathfinder_->cluster_size()) {
+        // Long path, search it on the abstract graph and only find the grid path to the first waypoint that can't
+        // be reached on this turn. Every step costs at least min_movement_cost_, so a waypoint further than that
+        // is out of reach.
+        std::vector<coordinates<size_t>> waypoints = hierarchical_pathfinder_->find_abstract_path(*this, location, target);
+        if (waypoints.empty()) return location;
+
+        coordinates<size_t> waypoint = waypoints.back();
+        for (const coordinates<size_t>& coords : waypoints) {
+            const size_t waypoint_distance = (location.x > coords.x ? location.x - coords.x : coords.x - location.x)
+                                           + (location.y > coords.y ? location.y - coords.y : coords.y - location.y);
+            if (waypoint_distance * min_movement_cost_ > movement_range) {
+                waypoint = coords;
+                break;
             }
         }
-        movements_left--;
+        path = find_path(location, waypoint);
     }
 
-    // The target tile or the one selected near it was unreachable, return the starting location
-    return location;
+    // Short path, or the waypoint was blocked by units
+    if (path.empty()) {
+        path = find_path(location, target);
+    }
+
+    // Walk along the path as far as the movement range allows. If the target was unreachable the path is empty
+    // and the starting location is returned
+    coordinates<size_t> furthest = location;
+    size_t range_left = movement_range;
+    for (const coordinates<size_t>& coords : path) {
+        const size_t cost = movement_cost(coords);
+        if (cost > range_left) break;
+
+        range_left -= cost;
+        furthest = coords;
+    }
+
+    return furthest;
 }
 
 
@@ -814,7 +1033,7 @@ coordinates<size_t> Map::fastest_movement_to_target(const coordinates<size_t>& l
 void Map::print_map() const {
     for (size_t y = 0; y < height(); ++y) {
         for (size_t x = 0; x < width(); ++x) {
-            std::cout << all_terrains_(y, x)->get_repr();
+            std::cout << get_terrain(y, x)->get_repr();
         }
         std::cout << '\n';
     }
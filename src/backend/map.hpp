@@ -1,18 +1,27 @@
 #ifndef MAP
 #define MAP
 #include <vector>
+#include <array>
+#include <bit>
 #include <memory>
 #include <cstdint>
-#include <functional>
 #include <unordered_map>
+#include <optional>
 
 
 #include "const_terrains.hpp"
 #include "unit.hpp"
 #include "terrain.hpp"
 #include "matrix.hpp"
+#include "bit_grid.hpp"
+#include "los_policy.hpp"
+#include "fov.hpp"
+#include "fov_cache.hpp"
+#include "range_tables.hpp"
+#include "thread_pool.hpp"
 #include "timer.hpp"
 #include "building.hpp"
+#include "hierarchical_pathfinder.hpp"
 
 
 
@@ -22,17 +31,129 @@
  */ 
 class Map
 {
+    public:
+        // An entry of the building registry, the building and the coordinates it was built on
+        struct BuildingEntry
+        {
+            std::shared_ptr< Building > building;
+            coordinates<size_t> location;
+        };
+
     private:
 
         /*
         * We will create a board into this container ( NOTE: you can specify a custom board size ).
-        * The size_t in the Terrain template is used to define the template type for coordinates,
-        * so basically the maximum coordinate value. 
+        * Every tile only stores the id of its terrain (see ConstTerrain::TerrainId), the properties
+        * of the terrain are then looked up from <terrain_properties_>.
         */
-        Matrix< std::shared_ptr< const Terrain >> all_terrains_;
+        Matrix< uint8_t > all_terrains_;
         //Raw pointer since the map doesn't have ownership of units
         Matrix< Unit* > all_units_;
-        Matrix< std::shared_ptr< Building >> all_buildings_;
+        // Reverse index of <all_units_> so a unit's location can be found without scanning the whole grid.
+        // Kept up to date by add_unit, remove_unit and move_unit
+        std::unordered_map< const Unit*, coordinates<size_t> > unit_locations_;
+
+        // Buildings are few compared to the amount of tiles, so they're kept in a sparse registry
+        // with a tile index (y * width + x) -> registry index hash for the per tile lookups.
+        std::vector< BuildingEntry > buildings_;
+        std::unordered_map< size_t, size_t > building_at_tile_;
+        // Incremented every time a building is added or removed
+        size_t buildings_version_ = 0;
+
+        // Bit layers of the properties that the searches and LoS check for every tile they visit.
+        // The terrain layers are kept up to date by update_terrain and the occupancy layer by add_unit, move_unit and remove_unit
+        BitGrid walkable_;
+        BitGrid see_through_;
+        BitGrid shoot_through_;
+        BitGrid occupied_;
+
+        /*
+        * Connected regions of the walkable terrain, two tiles with the same label can be walked between
+        * if no units are in the way. Label 0 means the tile isn't walkable. The labels are only built when
+        * they're first needed, after that update_terrain keeps them up to date by merging or splitting the
+        * regions next to the changed tile.
+        */
+        Matrix< uint32_t > region_labels_;
+        // amount of tiles in each region, indexed by label. Labels of regions that were merged away have size 0 and are reused
+        std::vector< size_t > region_sizes_;
+        std::vector< uint32_t > free_region_labels_;
+        bool regions_built_ = false;
+
+        void build_regions();
+        uint32_t new_region_label();
+        // gives the tiles connected to (y, x) that have the label <from> the label <to>, returns the amount of tiles relabeled
+        size_t relabel_region(size_t y, size_t x, uint32_t from, uint32_t to);
+        // updates the regions after the walkability of the tile changed
+        void update_regions(size_t y, size_t x);
+
+        // Incremented every time the terrain of a tile changes
+        size_t terrain_version_ = 0;
+
+        // Results of line_of_sight_check, cleared when <terrain_version_> changes
+        mutable FovCache fov_cache_;
+
+        // Abstract graph for long paths, only built for maps where it's enabled with enable_hierarchical_pathfinding
+        std::optional< HierarchicalPathfinder > hierarchical_pathfinder_;
+
+        // sets the bits of the terrain layers on the given tile from its terrain
+        void update_terrain_layers(size_t y, size_t x);
+
+        /*
+        * Scratch buffers that are reused between the searches instead of allocating and clearing
+        * width * height sized containers on every call. A tile is visited in the current search
+        * only if its stamp in <visited_generation> equals <generation>, so starting a new search
+        * is just incrementing <generation>.
+        */
+        struct SearchBuffers
+        {
+            std::vector<uint32_t> visited_generation;
+            std::vector<uint32_t> distance;
+            std::vector<uint32_t> parent;
+            std::vector<std::vector<uint32_t>> buckets;
+            uint32_t generation = 0;
+
+            // entry of the A* open list, ordered by the estimated total cost and then by the distance travelled
+            struct HeapNode
+            {
+                uint32_t estimate;
+                uint32_t distance;
+                uint32_t idx;
+
+                inline bool operator > ( const HeapNode& a ) const noexcept
+                {
+                    return estimate != a.estimate ? estimate > a.estimate : distance < a.distance;
+                }
+            };
+            std::vector<HeapNode> open_list;
+
+            // makes sure the buffers fit <tiles> tiles and starts a new generation
+            void start_search(size_t tiles);
+
+            [[nodiscard]]
+            inline bool visited(size_t idx) const
+            {
+                return visited_generation[idx] == generation;
+            }
+
+            inline void visit(size_t idx, uint32_t tile_distance)
+            {
+                visited_generation[idx] = generation;
+                distance[idx] = tile_distance;
+            }
+        };
+
+        // Returns the buffers of the calling thread
+        static SearchBuffers& search_buffers();
+
+        // Calls <func> with the (y, x) of each of the 4 neighbours of (y, x) that are inside of the map
+        template<typename Func>
+        inline void for_each_neighbour(size_t y, size_t x, Func&& func) const
+        {
+            if (y > 0) func(y - 1, x);
+            if (x + 1 < width()) func(y, x + 1);
+            if (y + 1 < height()) func(y + 1, x);
+            if (x > 0) func(y, x - 1);
+        }
         
         // we define the directions from the Helper tools that we'll use in directions handling
         std::vector< Helper::Directions > directions_ = { 
@@ -49,6 +170,30 @@ class Map
             {-1, 0} 
         };
 
+        /*
+        * Flyweight table of the terrain properties used by the movement and LoS searches,
+        * indexed by terrain id. Built once from the Terrains in ConstTerrain so the hot
+        * queries don't have to touch the shared_ptrs at all.
+        */
+        struct TerrainProperties
+        {
+            uint8_t movement_cost;
+            bool can_walk;
+            bool can_see;
+            bool can_shoot;
+            bool can_build;
+        };
+
+        static const std::array< TerrainProperties, ConstTerrain::terrain_count > terrain_properties_;
+        // the cheapest movement cost of a walkable terrain, used to keep the A* heuristic admissible
+        static const uint8_t min_movement_cost_;
+
+        [[nodiscard]]
+        inline const TerrainProperties& properties( size_t y, size_t x ) const
+        {
+            return terrain_properties_[ all_terrains_( y, x ) ];
+        }
+
 
     public:
         /**
@@ -79,13 +224,49 @@ class Map
             return all_terrains_.height();
         }
 
+        /**
+         * @brief Builds the hierarchical pathfinder, after which fastest_movement_to_target searches long paths
+         * on its abstract graph and only refines the part that is moved on this turn on the grid.
+         * Worth it on large maps, on small maps plain A* is fast enough.
+         *
+         * @param cluster_size the side length of the clusters of the abstract graph
+         */
+        void enable_hierarchical_pathfinding(size_t cluster_size = 16);
+
+        [[nodiscard]]
+        bool hierarchical_pathfinding_enabled() const;
+
+        /**
+         * @brief The cheapest movement cost of a walkable terrain, a lower bound for the cost of any step.
+         */
+        [[nodiscard]]
+        static uint8_t min_movement_cost();
+
         void update_terrain(char terrain, size_t y, size_t x);
 
-        std::shared_ptr<const Terrain> get_terrain(size_t y, size_t x);
+        const std::shared_ptr<const Terrain>& get_terrain(size_t y, size_t x) const;
 
         void update_terrain(char terrain, const coordinates<size_t>& coords);
 
-        std::shared_ptr<const Terrain> get_terrain(const coordinates<size_t>& coords);
+        const std::shared_ptr<const Terrain>& get_terrain(const coordinates<size_t>& coords) const;
+
+        [[nodiscard]]
+        uint8_t get_terrain_id(size_t y, size_t x) const;
+
+        /**
+         * @brief Change counter for the terrain, gets incremented every time update_terrain is called.
+         * Anything calculated from the terrain (like what units see) can be kept until this changes.
+         */
+        [[nodiscard]]
+        inline size_t terrain_version() const
+        {
+            return terrain_version_;
+        }
+
+        [[nodiscard]]
+        size_t movement_cost(size_t y, size_t x) const;
+        [[nodiscard]]
+        size_t movement_cost(const coordinates<size_t>& coords) const;
 
 
         bool are_valid_coords(size_t y, size_t x) const;
@@ -102,15 +283,26 @@ class Map
         bool remove_building(size_t y, size_t x);
         bool remove_building(const coordinates<size_t>& coords);
 
-        std::shared_ptr<Building> get_building(size_t y, size_t x);
-        std::shared_ptr<Building> get_building(const coordinates<size_t>& coords);
+        std::shared_ptr<Building> get_building(size_t y, size_t x) const;
+        std::shared_ptr<Building> get_building(const coordinates<size_t>& coords) const;
         std::vector<std::shared_ptr<Building>> get_all_buildings() const;
 
-        bool has_weapon_building(size_t y, size_t x);
-        bool has_weapon_building(const coordinates<size_t>& coords);
+        /**
+         * @brief Returns every building on the map along with its location, in no particular order.
+         */
+        const std::vector<BuildingEntry>& get_building_entries() const;
+
+        /**
+         * @brief Change counter for the buildings, gets incremented every time a building is added or removed.
+         * Can be used to skip work when nothing has been built or removed since the last check.
+         */
+        size_t buildings_version() const;
+
+        bool has_weapon_building(size_t y, size_t x) const;
+        bool has_weapon_building(const coordinates<size_t>& coords) const;
 
-        bool has_healing_building(size_t y, size_t x);
-        bool has_healing_building(const coordinates<size_t>& coords);
+        bool has_healing_building(size_t y, size_t x) const;
+        bool has_healing_building(const coordinates<size_t>& coords) const;
 
         bool can_build_on(size_t y, size_t x) const;
         bool can_build_on(const coordinates<size_t>& coords) const;
@@ -124,10 +316,47 @@ class Map
         bool has_unit(size_t y, size_t x) const;
         bool has_unit(const coordinates<size_t>& coords) const;
 
-        Unit* get_unit(size_t y, size_t x);
-        Unit* get_unit(const coordinates<size_t>& coords);
+        [[nodiscard]]
+        inline bool can_see_through(size_t y, size_t x) const
+        {
+            return see_through_.test(y, x);
+        }
+        [[nodiscard]]
+        inline bool can_shoot_through(size_t y, size_t x) const
+        {
+            return shoot_through_.test(y, x);
+        }
+
+        [[nodiscard]]
+        inline const BitGrid& walkable_layer() const
+        {
+            return walkable_;
+        }
+        [[nodiscard]]
+        inline const BitGrid& see_through_layer() const
+        {
+            return see_through_;
+        }
+        [[nodiscard]]
+        inline const BitGrid& shoot_through_layer() const
+        {
+            return shoot_through_;
+        }
+        [[nodiscard]]
+        inline const BitGrid& occupied_layer() const
+        {
+            return occupied_;
+        }
+
+        /**
+         * @brief Returns a layer of the tiles that can be moved to right now (walkable and not occupied).
+         */
+        BitGrid free_tiles_layer() const;
+
+        Unit* get_unit(size_t y, size_t x) const;
+        Unit* get_unit(const coordinates<size_t>& coords) const;
 
-        coordinates<size_t> get_unit_location(Unit* unit_ptr) const;
+        coordinates<size_t> get_unit_location(const Unit* unit_ptr) const;
         coordinates<size_t> get_building_location(std::shared_ptr<Building> building_ptr) const;
 
         bool add_unit(size_t y, size_t x, Unit* unit);
@@ -157,7 +386,7 @@ class Map
 
 
         // add the new Terrains into the board
-        constexpr inline void create_board() noexcept;
+        inline void create_board() noexcept;
 
         /**
          * @brief Get the neighbor of a given location from a specified direction
@@ -197,7 +426,8 @@ class Map
 
         /**
          * @brief Uses Andres circle drawing algorithm to get the 
-         * location of the furthest tile that the unit can see
+         * location of the furthest tile that the unit can see. The circles of the ranges
+         * up to RangeTables::max_range are precomputed, so they're only translated to <location>
          * @param location the location of the unit
          * @param visibility_range the distance to which the unit can see
          * @return std::vector< coordinates<size_t> > 
@@ -209,14 +439,65 @@ class Map
         std::vector<coordinates<size_t>> get_aoe_affected_coords(const coordinates<size_t>& location, const uint32_t range);
 
         /**
-         * @brief Checks which coordinates around the player in specified range are 'visible' (not blocked by coordinates that return false from predicate function)
+         * @brief The tiles with a unit on them that an area of effect at <location> reaches: tiles within <range> that
+         * have a line of sight to <location> through terrain that can be shot through. Gives the same tiles as filtering
+         * get_aoe_affected_coords with has_unit, but only the occupied tiles of the disc around <location> are looked at
+         * (see RangeTables) and the line of sight is checked point to point to each of them.
+         *
+         * @return std::vector<coordinates<size_t>> the coordinates of the affected units, sorted
+         */
+        std::vector<coordinates<size_t>> get_aoe_affected_unit_coords(const coordinates<size_t>& location, const uint32_t range) const;
+
+        /**
+         * @brief The tiles with a unit on them within <range> of <location> that are in the line of sight of <location> with the
+         * blocking <Policy>. Only the occupied tiles of the disc around <location> are looked at, a word of the occupancy layer at a time.
+         *
+         * @return std::vector<coordinates<size_t>> the coordinates of the units, sorted
+         */
+        template<typename Policy>
+        std::vector<coordinates<size_t>> units_in_sight(const coordinates<size_t>& location, const uint32_t range) const;
+
+        /**
+         * @brief Checks which coordinates around the player in specified range are 'visible' (not blocked by tiles that <Policy> says block LoS).
+         * Uses symmetric shadowcasting (see fov.hpp), so if a tile can be seen from another, the other can be seen from it too.
+         * The results are cached until the terrain changes, see fov_cache().
          * 
+         * @tparam Policy one of the blocking policies in LosPolicy
          * @param location location from which the check is done
-         * @param range The distance to which the unit can see
-         * @param predicate function that takes coordinates and returns false if it stops LoS
-         * @return std::vector< coordinates<size_t> > the tiles that are within LoS
+         * @param range The distance to which the unit can see, tiles with dx^2 + dy^2 <= range^2 + range are in range
+         * @return std::vector< coordinates<size_t> > the tiles that are within LoS, sorted
+         */
+        template<typename Policy>
+        std::vector< coordinates<size_t> > line_of_sight_check( const coordinates<size_t>& location, const uint32_t range ) const;
+
+        /**
+         * @brief The cache of the line_of_sight_check results, its hit and miss counters tell how much work repeated checks saved.
          */
-        std::vector< coordinates<size_t> > line_of_sight_check( const coordinates<size_t>& location, const uint32_t range, const std::function<bool(int64_t y, int64_t x)>& predicate);
+        [[nodiscard]]
+        inline FovCache& fov_cache() const
+        {
+            return fov_cache_;
+        }
+
+        /**
+         * @brief Same as line_of_sight_check, but sets the bits of the visible tiles in <visible> instead of returning them.
+         * The bits that are already set are left as they are, so the views of several units can be combined into one grid.
+         *
+         * @param visible grid the size of the map
+         */
+        template<typename Policy>
+        void field_of_view( const coordinates<size_t>& location, const uint32_t range, BitGrid& visible ) const;
+
+        /**
+         * @brief The field of view of every location in <locations> combined into <visible>. With a <pool> the views are
+         * calculated in parallel, every job into its own grid, and the grids are then OR-ed together, so the result is the
+         * same with any amount of jobs.
+         *
+         * @param visible grid the size of the map, the bits that are already set are left as they are
+         * @param pool the threads to use, nullptr to calculate the views on the calling thread
+         */
+        template<typename Policy>
+        void field_of_view( const std::vector< coordinates<size_t> >& locations, const uint32_t range, BitGrid& visible, ThreadPool* pool = nullptr ) const;
         
         /**
          * @brief Checks if there is a line of sight (los) from coordinates a to coordinates b.
@@ -225,7 +506,15 @@ class Map
          * @param b End point for los.
          * @param range The distance to which the unit can see.
          */
-        bool los_check_from_A_to_B(const coordinates<size_t>& a, const coordinates<size_t>& b, const uint32_t range);
+        bool los_check_from_A_to_B(const coordinates<size_t>& a, const coordinates<size_t>& b, const uint32_t range) const;
+
+        /**
+         * @brief Checks if <b> is in the line of sight of <a> with the blocking <Policy>. Gives the same result as looking for <b> in
+         * line_of_sight_check<Policy>(a, range), but only the tiles between the two are checked and targets out of range are
+         * rejected right away, so it's cheap enough to call for every possible target.
+         */
+        template<typename Policy>
+        bool has_line_of_sight( const coordinates<size_t>& a, const coordinates<size_t>& b, const uint32_t range ) const;
 
         /**
          * @brief Used for the fog of war feature
@@ -234,7 +523,7 @@ class Map
          * @param visibility_range The distance to which the unit can see
          * @return std::vector< coordinates<size_t> > the tiles that the unit sees
          */
-        std::vector< coordinates<size_t> > tiles_unit_sees( const coordinates<size_t>& location, const uint32_t visibility_range );
+        std::vector< coordinates<size_t> > tiles_unit_sees( const coordinates<size_t>& location, const uint32_t visibility_range ) const;
 
         /**
          * @brief get all the possible tiles that the unit can move to from the current location
@@ -246,12 +535,77 @@ class Map
         std::vector< coordinates<size_t> > possible_tiles_to_move_to( const coordinates<size_t>& location, const uint8_t movement_range );
 
 
-        // Breadth-first-search based algorithm on finding movement tiles
-        std::vector< coordinates< size_t > > possible_tiles_to_move_to3( const coordinates<size_t>& location, uint8_t movement_range );
+        /**
+         * @brief Bucket queue (Dial's algorithm) based search for the tiles that can be moved to from <location>.
+         * Reuses the search buffers between calls, so a call only costs as much as the amount of tiles it reaches.
+         *
+         * @param location Original the units current location
+         * @param movement_range the amount that the unit can traverse
+         * @return std::vector< coordinates< size_t > > the reachable tiles (not including <location>) in order of distance
+         */
+        std::vector< coordinates< size_t > > possible_tiles_to_move_to3( const coordinates<size_t>& location, uint8_t movement_range ) const;
+
+        /**
+         * @brief The label of the connected region of walkable terrain the tile is in, 0 if the tile can't be walked on.
+         * Tiles with the same label are connected when units aren't taken into account.
+         */
+        [[nodiscard]]
+        uint32_t region_of(size_t y, size_t x);
+        [[nodiscard]]
+        uint32_t region_of(const coordinates<size_t>& coords);
 
-        coordinates<size_t> get_closest_accessible_tile(const coordinates<size_t>& location);
+        /**
+         * @brief Same as region_of, but the labels have to be built already (see prepare_searches).
+         */
+        [[nodiscard]]
+        uint32_t region_of(size_t y, size_t x) const;
+        [[nodiscard]]
+        uint32_t region_of(const coordinates<size_t>& coords) const;
 
+        /**
+         * @brief Builds what the searches build on first use: the region labels and the changed clusters of the hierarchical
+         * pathfinder. After it the const searches only read the map, so they can be run from several threads at once
+         * as long as nothing changes the map.
+         */
+        void prepare_searches();
+
+        /**
+         * @brief Checks in constant time if there can be a path between the tiles. False means there's no path for sure,
+         * true that there's one if units don't block it.
+         */
+        [[nodiscard]]
+        bool are_connected(const coordinates<size_t>& a, const coordinates<size_t>& b);
+
+        /**
+         * @brief Breadth first search for the closest tile to <location> that can be moved to.
+         *
+         * @param location where to start the search from
+         * @param region if not 0, only tiles in this region are accepted
+         * @return coordinates<size_t> the closest tile that can be moved to, <location> if there is none
+         */
+        coordinates<size_t> get_closest_accessible_tile(const coordinates<size_t>& location, uint32_t region = 0) const;
+
+        /**
+         * @brief A* search for the cheapest path from <location> to <target>. Tiles with units on them are not walked through.
+         *
+         * @return std::vector< coordinates<size_t> > the tiles of the path not including <location>, empty if <target>
+         * can't be reached or is the same as <location>
+         */
+        std::vector< coordinates<size_t> > find_path(const coordinates<size_t>& location, const coordinates<size_t>& target) const;
+
+        /**
+         * @brief Finds the cheapest path to <target> and returns the furthest tile along it that can be reached
+         * with <movement_range>. If there's a unit on <target>, the closest tile that can be moved to is used instead.
+         *
+         * @return coordinates<size_t> the tile to move to, <location> if the target can't be reached
+         */
         coordinates<size_t> fastest_movement_to_target(const coordinates<size_t>& location, coordinates<size_t> target, uint8_t movement_range);
+
+        /**
+         * @brief Same as fastest_movement_to_target, but the searches have to be prepared already (see prepare_searches).
+         * Only reads the map, so it can be called from several threads at once.
+         */
+        coordinates<size_t> fastest_movement_to_target(const coordinates<size_t>& location, coordinates<size_t> target, uint8_t movement_range) const;
         
         void print_map() const;
 
@@ -263,4 +617,115 @@ class Map
 };
 
 
+template<typename Policy>
+void Map::field_of_view( const coordinates<size_t>& location, const uint32_t range, BitGrid& visible ) const
+{
+    Fov::shadowcast( location, range, width(), height(),
+        [this]( int64_t y, int64_t x ) { return !Policy::transparent( see_through_, shoot_through_, y, x ); },
+        [&visible]( int64_t y, int64_t x ) { visible.set( y, x ); } );
+}
+
+
+template<typename Policy>
+void Map::field_of_view( const std::vector< coordinates<size_t> >& locations, const uint32_t range, BitGrid& visible, ThreadPool* pool ) const
+{
+    if ( pool == nullptr || pool->jobs() == 1 || locations.size() < 2 ) {
+        for ( const coordinates<size_t>& location : locations ) {
+            field_of_view<Policy>( location, range, visible );
+        }
+        return;
+    }
+
+    std::vector< BitGrid > job_visible( pool->jobs(), BitGrid( height(), width() ) );
+    pool->parallel_for( locations.size(), [&]( size_t index, size_t job ) {
+        field_of_view<Policy>( locations[index], range, job_visible[job] );
+    } );
+    for ( const BitGrid& grid : job_visible ) {
+        BitGrid::unite( visible, grid, visible );
+    }
+}
+
+
+template<typename Policy>
+std::vector<coordinates<size_t>> Map::units_in_sight(const coordinates<size_t>& location, const uint32_t range) const
+{
+    std::vector<coordinates<size_t>> unit_coords;
+    if (!are_valid_coords(location)) return unit_coords;
+
+    const size_t top = location.y > range ? location.y - range : 0;
+    const size_t bottom = std::min<size_t>(location.y + range + 1, height());
+    for (size_t y = top; y < bottom; y++) {
+        const size_t half_width = RangeTables::disc_half_width(range, int64_t(y) - int64_t(location.y));
+        const size_t left = location.x > half_width ? location.x - half_width : 0;
+        const size_t right = std::min<size_t>(location.x + half_width + 1, width());
+
+        // The occupied tiles of the row between <left> and <right>, a word at a time
+        const uint64_t* words = occupied_.row(y);
+        for (size_t w = left / 64; w <= (right - 1) / 64; w++) {
+            uint64_t word = words[w];
+            if (w == left / 64) word &= ~uint64_t{0} << (left % 64);
+            if (w == (right - 1) / 64 && right % 64 != 0) word &= (uint64_t{1} << (right % 64)) - 1;
+
+            for (; word != 0; word &= word - 1) {
+                const coordinates<size_t> coords(w * 64 + std::countr_zero(word), y);
+                if (has_line_of_sight<Policy>(location, coords, range)) {
+                    unit_coords.push_back(coords);
+                }
+            }
+        }
+    }
+    return unit_coords;
+}
+
+
+template<typename Policy>
+bool Map::has_line_of_sight( const coordinates<size_t>& a, const coordinates<size_t>& b, const uint32_t range ) const
+{
+    return Fov::is_visible( a, b, range, width(), height(),
+        [this]( int64_t y, int64_t x ) { return !Policy::transparent( see_through_, shoot_through_, y, x ); } );
+}
+
+
+template<typename Policy>
+std::vector< coordinates<size_t> > Map::line_of_sight_check( const coordinates<size_t>& location, const uint32_t range ) const
+{
+    std::vector< coordinates<size_t> > visible_coords;
+    if ( FovCache::Result cached = fov_cache_.find( terrain_version_, location, range, Policy::id ) ) {
+        visible_coords.reserve( cached->size() );
+        for ( const uint32_t index : *cached ) {
+            visible_coords.emplace_back( index % width(), index / width() );
+        }
+        return visible_coords;
+    }
+
+    // The visible tiles are marked in the search buffers, so the tiles revealed more than once are only added once.
+    // Going through the square around <location> row by row then gives the tiles in sorted order.
+    SearchBuffers& buffers = search_buffers();
+    buffers.start_search( width() * height() );
+
+    Fov::shadowcast( location, range, width(), height(),
+        [this]( int64_t y, int64_t x ) { return !Policy::transparent( see_through_, shoot_through_, y, x ); },
+        [&buffers, this]( int64_t y, int64_t x ) { buffers.visit( y * width() + x, 0 ); } );
+
+    // Only the rows of the disc of <range> around <location> can have visible tiles
+    std::vector<uint32_t> indices;
+    const size_t top = location.y > range ? location.y - range : 0;
+    const size_t bottom = std::min<size_t>( location.y + range + 1, height() );
+    for ( size_t y = top; y < bottom; y++ ) {
+        const size_t half_width = RangeTables::disc_half_width( range, int64_t( y ) - int64_t( location.y ) );
+        const size_t left = location.x > half_width ? location.x - half_width : 0;
+        const size_t right = std::min<size_t>( location.x + half_width + 1, width() );
+        for ( size_t x = left; x < right; x++ ) {
+            if ( buffers.visited( y * width() + x ) ) {
+                visible_coords.emplace_back( x, y );
+                indices.push_back( uint32_t( y * width() + x ) );
+            }
+        }
+    }
+
+    fov_cache_.store( terrain_version_, location, range, Policy::id, std::move( indices ) );
+    return visible_coords;
+}
+
+
 #endif
@@ -3,39 +3,164 @@
 #include <vector>
 #include <cstdint>
 #include <cassert>
+#include <algorithm>
 
 #include "coordinates.hpp"
 
 
+/**
+ * @brief Memory layout policies for the Matrix class. A layout maps the (y, x) of a cell into
+ * an index of the underlying std::vector and tells how big the vector has to be.
+ * Layouts other than RowMajor pad the grid, so the vector can be larger than width * height.
+ */
+namespace MatrixLayout
+{
+
+// The usual layout, rows are stored one after the other
+class RowMajor
+{
+    private:
+        size_t width_ = 0;
+        size_t height_ = 0;
+
+    public:
+        RowMajor( size_t height, size_t width ) noexcept : width_(width), height_(height) { }
+
+        [[nodiscard]]
+        constexpr size_t storage_size() const noexcept
+        {
+            return width_ * height_;
+        }
+
+        [[nodiscard]]
+        constexpr size_t index( const size_t y, const size_t x ) const noexcept
+        {
+            return y * width_ + x;
+        }
+};
+
+// The grid is split into <TileSide> x <TileSide> tiles that are stored row-major,
+// cells inside of a tile are also stored row-major. Vertically close cells are then close in memory as well.
+template<size_t TileSide = 8>
+class Tiled
+{
+    static_assert( TileSide > 0 && ( TileSide & ( TileSide - 1 ) ) == 0, "Tile side has to be a power of two" );
+
+    private:
+        static constexpr size_t tile_size_ = TileSide * TileSide;
+        size_t tiles_per_row_ = 0;
+        size_t tile_rows_ = 0;
+
+    public:
+        Tiled( size_t height, size_t width ) noexcept : 
+            tiles_per_row_( ( width + TileSide - 1 ) / TileSide ), tile_rows_( ( height + TileSide - 1 ) / TileSide ) { }
+
+        [[nodiscard]]
+        constexpr size_t storage_size() const noexcept
+        {
+            return tiles_per_row_ * tile_rows_ * tile_size_;
+        }
+
+        [[nodiscard]]
+        constexpr size_t index( const size_t y, const size_t x ) const noexcept
+        {
+            return ( ( y / TileSide ) * tiles_per_row_ + x / TileSide ) * tile_size_ + ( y % TileSide ) * TileSide + x % TileSide;
+        }
+};
+
+// Z-order curve, the bits of x and y are interleaved. Both sides are padded to the next power of two,
+// if one side is longer its extra high bits are placed above the interleaved bits
+class Morton
+{
+    private:
+        size_t interleaved_bits_ = 0;
+        size_t interleaved_mask_ = 0;
+        size_t storage_size_ = 0;
+
+        [[nodiscard]]
+        static constexpr size_t bits_needed( size_t n ) noexcept
+        {
+            size_t bits = 0;
+            while ( ( size_t{1} << bits ) < n ) {
+                bits++;
+            }
+            return bits;
+        }
+
+        // spreads the lower 32 bits of <v> so that there is a zero bit between each of them
+        [[nodiscard]]
+        static constexpr uint64_t spread_bits( uint64_t v ) noexcept
+        {
+            v &= 0x00000000ffffffff;
+            v = ( v | ( v << 16 ) ) & 0x0000ffff0000ffff;
+            v = ( v | ( v << 8 ) ) & 0x00ff00ff00ff00ff;
+            v = ( v | ( v << 4 ) ) & 0x0f0f0f0f0f0f0f0f;
+            v = ( v | ( v << 2 ) ) & 0x3333333333333333;
+            v = ( v | ( v << 1 ) ) & 0x5555555555555555;
+            return v;
+        }
+
+    public:
+        Morton( size_t height, size_t width ) noexcept
+        {
+            const size_t width_bits = bits_needed( width );
+            const size_t height_bits = bits_needed( height );
+            interleaved_bits_ = std::min( width_bits, height_bits );
+            interleaved_mask_ = ( size_t{1} << interleaved_bits_ ) - 1;
+            storage_size_ = size_t{1} << ( width_bits + height_bits );
+        }
+
+        [[nodiscard]]
+        constexpr size_t storage_size() const noexcept
+        {
+            return storage_size_;
+        }
+
+        [[nodiscard]]
+        constexpr size_t index( const size_t y, const size_t x ) const noexcept
+        {
+            // only one of x or y can have bits above the interleaved ones
+            const size_t high_bits = ( x >> interleaved_bits_ ) | ( y >> interleaved_bits_ );
+            return ( high_bits << ( 2 * interleaved_bits_ ) )
+                | spread_bits( x & interleaved_mask_ ) | ( spread_bits( y & interleaved_mask_ ) << 1 );
+        }
+};
+
+}
+
 
 /**
  * @brief class definition for a Matrix class that contains a std::vector
  * as the underlying container. The class is more used as a grid based container 
  * and not used to make mathematical matrix operations on its data.
+ * The order of the cells in the vector is decided by the <Layout> policy (see MatrixLayout),
+ * the iterators go through the vector in that order, including the possible padding.
  */
-template<typename T>
+template<typename T, typename Layout = MatrixLayout::RowMajor>
 class Matrix
 {
     private: 
-        std::vector<T> data_;
         size_t width_ = 0;
         size_t height_ = 0;
+        Layout layout_;
+        std::vector<T> data_;
 
 
     public:
         // initialise a n x n matrix
-        Matrix( size_t n ) noexcept : data_(n * n), width_(n), height_(n) { }
+        Matrix( size_t n ) noexcept : width_(n), height_(n), layout_(n, n), data_(layout_.storage_size()) { }
 
         // initialise a n x m matrix
-        Matrix( size_t height, size_t width ) noexcept : data_(height * width), width_(width), height_(height) { }
+        Matrix( size_t height, size_t width ) noexcept : width_(width), height_(height), layout_(height, width), data_(layout_.storage_size()) { }
 
 
         // initialise a n x n matrix with the <value> at every cell
-        Matrix( size_t n, T value ) noexcept : data_(n * n, value), width_(n), height_(n) { }
+        Matrix( size_t n, T value ) noexcept : width_(n), height_(n), layout_(n, n), data_(layout_.storage_size(), value) { }
 
 
         // initialise a n x m matrix with the <value> initialised at every cell
-        Matrix( size_t height, size_t width, T value ) noexcept : data_(height * width, value), width_(width), height_(height) { }
+        Matrix( size_t height, size_t width, T value ) noexcept : 
+            width_(width), height_(height), layout_(height, width), data_(layout_.storage_size(), value) { }
 
         [[nodiscard]]
         constexpr size_t size() const noexcept
@@ -61,7 +186,7 @@ class Matrix
         constexpr T& operator () ( const size_t y, const size_t x ) noexcept
         {
             //assert(y < height_ && x < width_);
-            return data_[ y * width_ + x ];
+            return data_[ layout_.index( y, x ) ];
         }
 
         // works the same way as accessing with [i][j] as std::vector<std::vector<T>>
@@ -69,7 +194,7 @@ class Matrix
         constexpr const T& operator () ( const size_t y, const size_t x ) const noexcept
         {
             //assert(y < height_ && x < width_);
-            return data_[ y * width_ + x ];
+            return data_[ layout_.index( y, x ) ];
         }
 
         // this is a simpler way of accessing [y][x] by using a set of coordinates
@@ -78,7 +203,7 @@ class Matrix
         constexpr inline T& operator [] ( const coordinates<D>& a_coordinates ) noexcept
         {
             //assert(a_coordinates.y >= 0 && a_coordinates.y < height_ && a_coordinates.x >= 0 && a_coordinates.x < width_);
-            return data_[ a_coordinates.y * width_ + a_coordinates.x ];
+            return data_[ layout_.index( a_coordinates.y, a_coordinates.x ) ];
         }
 
         template<typename D>
@@ -86,7 +211,7 @@ class Matrix
         constexpr inline const T& operator [] ( const coordinates<D>& a_coordinates ) const noexcept
         {
             //assert(a_coordinates.y >= 0 && a_coordinates.y < height_ && a_coordinates.x >= 0 && a_coordinates.x < width_);
-            return data_[ a_coordinates.y * width_ + a_coordinates.x ];
+            return data_[ layout_.index( a_coordinates.y, a_coordinates.x ) ];
         }
 
         template<typename D>
@@ -94,7 +219,7 @@ class Matrix
         constexpr inline T& operator () ( const coordinates<D>& a_coordinates ) noexcept
         {
             //assert(a_coordinates.y >= 0 && a_coordinates.y < height_ && a_coordinates.x >= 0 && a_coordinates.x < width_);
-            return data_[ a_coordinates.y * width_ + a_coordinates.x ];
+            return data_[ layout_.index( a_coordinates.y, a_coordinates.x ) ];
         }
 
         template<typename D>
@@ -102,7 +227,7 @@ class Matrix
         constexpr inline const T& operator () ( const coordinates<D>& a_coordinates ) const noexcept
         {
             //assert(a_coordinates.y >= 0 && a_coordinates.y < height_ && a_coordinates.x >= 0 && a_coordinates.x < width_);
-            return data_[ a_coordinates.y * width_ + a_coordinates.x ];
+            return data_[ layout_.index( a_coordinates.y, a_coordinates.x ) ];
         }
 
         std::vector<T>::iterator begin() { return data_.begin(); }
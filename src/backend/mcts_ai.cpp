@@ -0,0 +1,380 @@
+#include <algorithm>
+#include <cmath>
+
+#include "mcts_ai.hpp"
+#include "action.hpp"
+#include "game.hpp"
+#include "team.hpp"
+#include "unit.hpp"
+#include "item.hpp"
+#include "map.hpp"
+#include "thread_pool.hpp"
+
+namespace {
+
+size_t steps_between(const coordinates<size_t>& a, const coordinates<size_t>& b) {
+    return (a.x > b.x ? a.x - b.x : b.x - a.x) + (a.y > b.y ? a.y - b.y : b.y - a.y);
+}
+
+// Unit::deal_damage hits when a roll of 0-100 is at most the accuracy
+bool roll_hit(int accuracy, std::mt19937& rng) {
+    return std::uniform_int_distribution<int>(0, 100)(rng) <= accuracy;
+}
+
+double hit_chance(int accuracy) {
+    return std::clamp((accuracy + 1) / 101.0, 0.0, 1.0);
+}
+
+} // namespace
+
+
+MctsAI::MctsAI(Game& game, Team& team) : game_(game), map_(game.get_map()), team_(team), rules_(game, team) {}
+
+MctsAI::~MctsAI() = default;
+
+void MctsAI::set_planning_jobs(size_t jobs) {
+    planning_jobs_ = jobs;
+    planning_pool_.reset();
+}
+
+void MctsAI::set_planning_seed(uint64_t seed) {
+    planning_seed_ = seed;
+    planned_turns_ = 0;
+}
+
+void MctsAI::set_turn_time_budget(std::chrono::milliseconds budget) {
+    turn_budget_ = budget;
+}
+
+void MctsAI::set_iteration_limit(size_t iterations) {
+    iteration_limit_ = iterations;
+}
+
+int MctsAI::team_id() const {
+    return team_.get_id();
+}
+
+void MctsAI::take_snapshot() {
+    start_state_ = std::make_unique<GameState>(game_);
+    team_id_ = team_.get_id();
+    units_.clear();
+    for (Team& team : game_.get_teams()) {
+        for (Unit& unit : team.get_units()) {
+            units_.push_back(&unit);
+        }
+    }
+
+    // The enemy moves as close as it can and shoots with its best weapon, like the threat of the influence map
+    const GameState& state = *start_state_;
+    const size_t reach = InfluenceMap::reach();
+    shots_.assign(state.units().size() * (reach + 1), {0, 0});
+    for (size_t u = 0; u < state.units().size(); u++) {
+        const GameState::UnitState& unit = state.units()[u];
+        for (size_t distance = 0; distance <= reach; distance++) {
+            const int shot_distance = std::max<int>(1, int(distance) - int(unit_consts.move_range));
+            Shot& shot = shots_[u * (reach + 1) + distance];
+            double best_damage = 0;
+            for (uint32_t i = 0; i < unit.item_count; i++) {
+                const GameState::ItemStats& item = state.items()[state.unit_items()[unit.first_item + i]];
+                if (item.kind != GameState::ItemStats::Kind::weapon) continue;
+                const int damage = Weapon::calculate_damage_dealt(item.damage, item.falloff, shot_distance);
+                if (hit_chance(item.accuracy) * damage > best_damage) {
+                    best_damage = hit_chance(item.accuracy) * damage;
+                    shot = {item.accuracy, damage};
+                }
+            }
+        }
+    }
+}
+
+std::vector<MctsAI::Option> MctsAI::generate_options(uint32_t index) const {
+    const GameState& state = *start_state_;
+    const GameState::UnitState& unit = state.units()[index];
+    const InfluenceMap& influence = rules_.influence_map();
+
+    // The best healing item of the unit, healing is only tried with it
+    int heal_amount = 0;
+    uint32_t heal_item = 0;
+    for (uint32_t i = 0; i < unit.item_count; i++) {
+        const GameState::ItemStats& item = state.items()[state.unit_items()[unit.first_item + i]];
+        if (item.kind == GameState::ItemStats::Kind::healing && item.heal_amount > heal_amount) {
+            heal_amount = item.heal_amount;
+            heal_item = i;
+        }
+    }
+
+    std::vector<coordinates<size_t>> destinations = map_.possible_tiles_to_move_to3(unit.location, unit_consts.move_range);
+    destinations.push_back(unit.location);
+
+    std::vector<Option> options;
+    std::vector<Option> moves;
+    for (const coordinates<size_t>& destination : destinations) {
+        const double danger = influence.danger(destination);
+        moves.push_back({destination, Option::Kind::move, index, 0, -danger});
+
+        for (const coordinates<size_t>& coords : map_.units_in_sight<LosPolicy::SeeThrough>(destination, unit_consts.visual_range)) {
+            // The unit can see itself at its old location, healing itself then targets <destination>
+            const uint32_t target = state.unit_at(coords);
+            if (target == GameState::no_unit) continue;
+            const GameState::UnitState& target_unit = state.units()[target];
+            if (target_unit.hp <= 0) continue;
+
+            if (!is_ai_unit(target_unit)) {
+                // The weapon with the most expected damage from here
+                const size_t distance = steps_between(destination, target_unit.location);
+                double best_damage = 0;
+                uint32_t best_weapon = 0;
+                for (uint32_t i = 0; i < unit.item_count; i++) {
+                    const GameState::ItemStats& item = state.items()[state.unit_items()[unit.first_item + i]];
+                    if (item.kind != GameState::ItemStats::Kind::weapon) continue;
+                    const double damage = hit_chance(item.accuracy) * Weapon::calculate_damage_dealt(item.damage, item.falloff, distance);
+                    if (damage > best_damage) {
+                        best_damage = damage;
+                        best_weapon = i;
+                    }
+                }
+                if (best_damage <= 0) continue;
+                const double kill = best_damage >= target_unit.hp ? kill_bonus : 0;
+                options.push_back({destination, Option::Kind::attack, target, best_weapon, best_damage + kill - danger / 2});
+            } else if (heal_amount > 0 && target_unit.hp < unit_consts.max_hp) {
+                const double healed = std::min(heal_amount, unit_consts.max_hp - target_unit.hp);
+                options.push_back({destination, Option::Kind::heal, target, heal_item, healed - danger / 2});
+            }
+        }
+    }
+
+    // Nothing to fight or heal this turn, the rules move the unit
+    if (options.empty()) return options;
+
+    // A few of the safest plain moves, so the unit can also back off
+    std::stable_sort(moves.begin(), moves.end(), [](const Option& a, const Option& b) { return a.score > b.score; });
+    moves.resize(std::min<size_t>(moves.size(), 4));
+    options.insert(options.end(), moves.begin(), moves.end());
+
+    std::stable_sort(options.begin(), options.end(), [](const Option& a, const Option& b) { return a.score > b.score; });
+    if (options.size() > max_options) options.resize(max_options);
+    return options;
+}
+
+void MctsAI::apply(GameState& state, uint32_t unit_index, const Option& option, std::mt19937& rng) const {
+    const GameState::UnitState& unit = state.units()[unit_index];
+    if (unit.hp <= 0) return;
+
+    // Another unit may have moved to the destination first, then the move fails and the unit acts from where it is
+    if (option.destination != unit.location) {
+        state.make({GameState::Move::Kind::movement, unit_index, 0, option.destination}, rng);
+    }
+
+    if (option.kind == Option::Kind::move) return;
+    const GameState::UnitState& target = state.units()[option.target];
+    if (target.hp <= 0) return;
+    state.make({GameState::Move::Kind::use_item, unit_index, state.unit_items()[unit.first_item + option.item], target.location}, rng);
+}
+
+void MctsAI::enemy_answer(GameState& state, std::mt19937& rng) const {
+    const size_t reach = InfluenceMap::reach();
+    const std::vector<GameState::UnitState>& units = state.units();
+    for (uint32_t e = 0; e < units.size(); e++) {
+        const GameState::UnitState& enemy = units[e];
+        if (is_ai_unit(enemy) || enemy.hp <= 0) continue;
+
+        uint32_t target = GameState::no_unit;
+        size_t target_distance = 0;
+        for (uint32_t i = 0; i < units.size(); i++) {
+            if (!is_ai_unit(units[i]) || units[i].hp <= 0) continue;
+            const size_t distance = steps_between(enemy.location, units[i].location);
+            if (distance <= reach && (target == GameState::no_unit || units[i].hp < units[target].hp)) {
+                target = i;
+                target_distance = distance;
+            }
+        }
+        if (target == GameState::no_unit) continue;
+
+        const Shot& shot = shots_[e * (reach + 1) + target_distance];
+        if (shot.damage > 0 && roll_hit(shot.accuracy, rng)) {
+            state.change_hp(target, -shot.damage);
+        }
+    }
+}
+
+double MctsAI::evaluate(const GameState& state) const {
+    double balance = 0;
+    for (size_t i = 0; i < state.units().size(); i++) {
+        const GameState::UnitState& unit = state.units()[i];
+        const GameState::UnitState& start = start_state_->units()[i];
+        double lost = std::max(start.hp, 0) - std::max(unit.hp, 0);
+        if (unit.hp <= 0 && start.hp > 0) lost += kill_bonus;
+        balance += is_ai_unit(unit) ? -lost : lost;
+    }
+    return std::clamp(0.5 + balance / (2 * reward_scale_), 0.0, 1.0);
+}
+
+void MctsAI::simulate(GameState& state, std::vector<Node>& tree, size_t step, std::mt19937& rng) const {
+    const size_t root_depth = state.depth();
+    for (size_t k = 0; k < step; k++) {
+        apply(state, order_[k], options_[k][chosen_[k]], rng);
+    }
+    // Selection and expansion: go down the visited options until a unit has an option that hasn't been tried
+    std::vector<uint32_t> path{0};
+    uint32_t node = 0;
+    size_t k = step;
+    while (k < order_.size()) {
+        if (tree[node].children == 0) {
+            tree[node].first_child = tree.size();
+            tree[node].children = options_[k].size();
+            tree.resize(tree.size() + options_[k].size());
+        }
+
+        const Node& parent = tree[node];
+        uint32_t choice = 0;
+        const bool expanding = parent.expanded < parent.children;
+        if (expanding) {
+            choice = tree[node].expanded++;
+        } else {
+            double best = -1;
+            const double log_visits = std::log(double(parent.visits));
+            for (uint32_t c = 0; c < parent.children; c++) {
+                const Node& child = tree[parent.first_child + c];
+                const double ucb = child.value / child.visits + exploration * std::sqrt(log_visits / child.visits);
+                if (ucb > best) {
+                    best = ucb;
+                    choice = c;
+                }
+            }
+        }
+
+        node = tree[node].first_child + choice;
+        path.push_back(node);
+        apply(state, order_[k], options_[k][choice], rng);
+        k++;
+        if (expanding) break;
+    }
+
+    // Rollout: the rest of the units take their best looking option half of the time and a random one otherwise
+    for (; k < order_.size(); k++) {
+        const std::vector<Option>& options = options_[k];
+        const size_t choice = (rng() % 2 == 0) ? 0 : rng() % options.size();
+        apply(state, order_[k], options[choice], rng);
+    }
+    enemy_answer(state, rng);
+
+    const double reward = evaluate(state);
+    for (uint32_t visited : path) {
+        tree[visited].visits++;
+        tree[visited].value += reward;
+    }
+
+    while (state.depth() > root_depth) state.unmake();
+}
+
+uint32_t MctsAI::search(size_t step, std::chrono::steady_clock::time_point deadline) {
+    const size_t trees = planning_pool_->jobs();
+    std::vector<std::vector<Node>> forest(trees);
+    std::vector<size_t> simulations(trees, 0);
+
+    planning_pool_->parallel_for(trees, [&](size_t index, size_t) {
+        // Every tree has its own random numbers, so the result doesn't depend on which thread grows it
+        std::seed_seq seed{uint32_t(planning_seed_), uint32_t(planning_seed_ >> 32), uint32_t(planned_turns_), uint32_t(step), uint32_t(index)};
+        std::mt19937 rng(seed);
+        std::vector<Node>& tree = forest[index];
+        tree.emplace_back();
+        GameState state = *start_state_;
+
+        while (std::chrono::steady_clock::now() < deadline) {
+            if (iteration_limit_ != 0 && simulations[index] >= iteration_limit_) break;
+            simulate(state, tree, step, rng);
+            simulations[index]++;
+        }
+    });
+
+    // The visits of the root options of every tree together, the most visited option is the most promising
+    std::vector<uint32_t> visits(options_[step].size(), 0);
+    std::vector<double> values(options_[step].size(), 0);
+    for (size_t t = 0; t < trees; t++) {
+        const Node& root = forest[t][0];
+        for (uint32_t c = 0; c < root.children; c++) {
+            visits[c] += forest[t][root.first_child + c].visits;
+            values[c] += forest[t][root.first_child + c].value;
+        }
+        last_turn_simulations_ += simulations[t];
+    }
+
+    // Without the time to try every option the visits don't tell much, the option that scores best without search is taken
+    uint32_t best = 0;
+    if (std::find(visits.begin(), visits.end(), 0) != visits.end()) return best;
+    for (uint32_t c = 1; c < visits.size(); c++) {
+        if (visits[c] > visits[best] || (visits[c] == visits[best] && visits[c] > 0 && values[c] / visits[c] > values[best] / visits[best])) {
+            best = c;
+        }
+    }
+    return best;
+}
+
+void MctsAI::commit(uint32_t index, const Option& option) {
+    Unit& unit = *units_[index];
+    const coordinates<size_t> location = map_.get_unit_location(&unit);
+    coordinates<size_t> destination = option.destination;
+    if (destination != location && !map_.can_move_to_coords(destination.y, destination.x)) destination = location;
+    game_.add_action(std::make_shared<MovementAction>(location, destination, unit), team_.get_id());
+
+    if (option.kind == Option::Kind::move) return;
+    const coordinates<size_t> target = map_.get_unit_location(units_[option.target]);
+    game_.add_action(unit.get_inventory()[option.item]->get_action(target, unit), team_.get_id());
+}
+
+void MctsAI::generate_whole_teams_turns() {
+    const auto start = std::chrono::steady_clock::now();
+    const auto turn_deadline = start + turn_budget_;
+    if (planning_pool_ == nullptr) planning_pool_ = std::make_shared<ThreadPool>(planning_jobs_);
+    planned_turns_++;
+    last_turn_simulations_ = 0;
+
+    // The rules plan the units without anything to search, and their influence map scores the options
+    rules_.build_enemy_field();
+    take_snapshot();
+
+    order_.clear();
+    options_.clear();
+    chosen_.clear();
+    std::vector<Unit*> ruled_units;
+    for (Unit* unit : team_.get_alive_units()) {
+        const uint32_t index = start_state_->unit_index(unit->get_id());
+        std::vector<Option> options = generate_options(index);
+        if (options.empty()) {
+            ruled_units.push_back(unit);
+            continue;
+        }
+        order_.push_back(index);
+        options_.push_back(std::move(options));
+    }
+    reward_scale_ = double(unit_consts.max_hp + kill_bonus) * std::max<size_t>(order_.size(), 1);
+
+    // The units without anything to search are planned first, so the time they take isn't missing at the end of the turn.
+    // Committing a searched unit costs about as much as planning one of them, which is the first guess for the commits
+    std::chrono::steady_clock::duration longest_commit = std::chrono::steady_clock::duration::zero();
+    if (!ruled_units.empty()) {
+        const auto rules_start = std::chrono::steady_clock::now();
+        for (Unit* unit : ruled_units) {
+            rules_.generate_turn(*unit);
+        }
+        longest_commit = (std::chrono::steady_clock::now() - rules_start) / std::chrono::steady_clock::rep(ruled_units.size());
+        // The searches start from where the ruled units moved
+        take_snapshot();
+    }
+
+    // Every unit gets an equal share of the time that is left after committing the units that haven't been searched yet,
+    // each commit taking as long as the longest one so far
+    for (size_t step = 0; step < order_.size(); step++) {
+        const auto units_left = std::chrono::steady_clock::rep(order_.size() - step);
+        const auto now = std::chrono::steady_clock::now();
+        const auto left = turn_deadline > now ? turn_deadline - now : std::chrono::steady_clock::duration::zero();
+        const auto reserved = longest_commit * units_left;
+        const auto share = left > reserved ? (left - reserved) / units_left : std::chrono::steady_clock::duration::zero();
+        const uint32_t choice = search(step, now + share);
+        chosen_.push_back(choice);
+
+        const auto commit_start = std::chrono::steady_clock::now();
+        commit(order_[step], options_[step][choice]);
+        longest_commit = std::max(longest_commit, std::chrono::steady_clock::now() - commit_start);
+    }
+}
@@ -0,0 +1,170 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <cstdint>
+
+#include "coordinates.hpp"
+#include "ai_controller.hpp"
+#include "enemy_ai.hpp"
+#include "game_state.hpp"
+
+class Game;
+class Team;
+class Unit;
+class Map;
+class ThreadPool;
+
+/**
+ * @brief AI that plans its team's turn with Monte Carlo tree search. The units are decided one at a time in the order of the
+ * team: a unit's options are its reachable tiles combined with attacking an enemy or healing a teammate it would see from there,
+ * and every level of the tree below is the decision of the next unit. A simulation plays the rest of the turn with a fast
+ * rollout, lets the enemies answer and scores the damage done and taken.
+ *
+ * The hits are chance events: every simulation rolls each attack with the accuracy of the weapon and the damage of
+ * Weapon::calculate_damage_dealt. The outcomes of the attacks are only known at the end of the turn, so the tree is open loop:
+ * a node is the sequence of decisions, and the outcomes are rolled again in every simulation instead of branching on them.
+ *
+ * The search runs on every core with root parallelisation, each job growing its own tree with its own random numbers, and the
+ * visits of the root options are summed. Units that can't reach any enemy or teammate this turn are left to the rules of
+ * EnemyAI, which plan them before the search. Every searched unit then gets an equal share of what is left of the turn's
+ * time budget after the time committing the rest of the units takes, and when its time runs out the most visited option
+ * is taken, or the option that scores best without search if not every option was tried.
+ *
+ * Every job simulates on its own copy of the game as a GameState, making the moves of a simulation and taking them back
+ * afterwards. The enemies' answer doesn't look at the walls (see InfluenceMap), and building isn't searched.
+ */
+class MctsAI : public AIController {
+public:
+    /**
+     * @brief constructor for the MctsAI class
+     *
+     * @param game the game in which this AI will make moves for
+     * @param team the team that this AI controls
+     */
+    MctsAI(Game& game, Team& team);
+
+    ~MctsAI() override;
+
+    /**
+     * @brief Searches and queues the turns of the whole team within the turn time budget
+     */
+    void generate_whole_teams_turns() override;
+
+    /**
+     * @brief The amount of trees searched in parallel, 0 (the default) for the amount of hardware threads
+     */
+    void set_planning_jobs(size_t jobs) override;
+
+    void set_planning_seed(uint64_t seed) override;
+
+    int team_id() const override;
+
+    /**
+     * @brief The wall-clock time the search of a whole turn may take, the default is 500 ms
+     */
+    void set_turn_time_budget(std::chrono::milliseconds budget);
+
+    /**
+     * @brief Stops the search of each unit after <iterations> simulations per tree even if there's time left, 0 (the default)
+     * for no limit. With a limit that is reached before the time runs out the turns only depend on the seed and the amount of jobs.
+     */
+    void set_iteration_limit(size_t iterations);
+
+    /**
+     * @brief The amount of simulations run during the last turn, of all the units and trees together
+     */
+    [[nodiscard]]
+    inline size_t last_turn_simulations() const {
+        return last_turn_simulations_;
+    }
+
+private:
+    // An option of a unit: move to <destination> and then attack or heal <target>
+    struct Option {
+        enum class Kind { move, attack, heal };
+
+        coordinates<size_t> destination;
+        Kind kind;
+        // the index of the target in GameState::units
+        uint32_t target;
+        // the index of the weapon or healing item in the inventory of the unit
+        uint32_t item;
+        // how good the option looks without any search, the options are tried in this order
+        double score;
+    };
+
+    // The best shot of an enemy at a distance, see enemy_answer
+    struct Shot {
+        int accuracy;
+        int damage;
+    };
+
+    // A node of the tree is a decision of the unit at its depth, its children the options of the next unit
+    struct Node {
+        uint32_t first_child = 0;
+        uint32_t children = 0;
+        // children are expanded in order, the first <expanded> have been visited
+        uint32_t expanded = 0;
+        uint32_t visits = 0;
+        double value = 0;
+    };
+
+    Game& game_;
+    Map& map_;
+    Team& team_;
+    // plans the units that have nothing to search, its influence map scores the options
+    EnemyAI rules_;
+
+    std::chrono::milliseconds turn_budget_{500};
+    size_t iteration_limit_ = 0;
+    size_t planning_jobs_ = 0;
+    std::shared_ptr<ThreadPool> planning_pool_;
+    uint64_t planning_seed_ = 0;
+    uint64_t planned_turns_ = 0;
+    size_t last_turn_simulations_ = 0;
+
+    // The state of the turn being searched, units_ are the units of the game in the order of GameState::units
+    std::vector<Unit*> units_;
+    std::unique_ptr<GameState> start_state_;
+    int team_id_ = 0;
+    // the shot of every unit for every distance up to InfluenceMap::reach, units_ after each other
+    std::vector<Shot> shots_;
+    // the indices of the units that are searched, in the order they decide
+    std::vector<uint32_t> order_;
+    std::vector<std::vector<Option>> options_;
+    // the options chosen for the units before the one being searched
+    std::vector<uint32_t> chosen_;
+    double reward_scale_ = 1;
+
+    static constexpr size_t max_options = 32;
+    static inline double exploration = 0.7;
+    // a killed unit counts this much more than the hp it had
+    static inline int kill_bonus = 50;
+
+    // copies the game into start_state_ and works out the shots of the units
+    void take_snapshot();
+    // the options of the unit at <index> of the snapshot, sorted best first
+    std::vector<Option> generate_options(uint32_t index) const;
+
+    inline bool is_ai_unit(const GameState::UnitState& unit) const {
+        return unit.team_id == team_id_;
+    }
+
+    // moves the unit and rolls the outcome of its attack or healing
+    void apply(GameState& state, uint32_t unit, const Option& option, std::mt19937& rng) const;
+    // every enemy attacks the weakest unit of the team it can reach
+    void enemy_answer(GameState& state, std::mt19937& rng) const;
+    // 0.5 for an even turn, more the more the team came out ahead
+    double evaluate(const GameState& state) const;
+
+    // one simulation from the root of <tree>, which decides the unit at <step> of order_. The moves of the simulation
+    // are taken back from <state> at the end.
+    void simulate(GameState& state, std::vector<Node>& tree, size_t step, std::mt19937& rng) const;
+    // the index of the option to take for the unit at <step> of order_
+    uint32_t search(size_t step, std::chrono::steady_clock::time_point deadline);
+
+    // queues the movement and the action of the option with the game
+    void commit(uint32_t unit, const Option& option);
+};
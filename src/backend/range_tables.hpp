@@ -0,0 +1,130 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+
+
+/*
+ * Offset tables for the small ranges that units see and weapons hit with, generated at compile time so the
+ * circle geometry isn't redone on every call. The tables cover the ranges up to <max_range>, longer ranges
+ * are calculated on the fly.
+ */
+namespace RangeTables
+{
+
+constexpr uint32_t max_range = 32;
+
+// An offset from the center of a stencil
+struct Offset
+{
+    int8_t dx;
+    int8_t dy;
+};
+
+/*
+ * The tiles of a circle of radius <range> drawn with the Andres algorithm, in the same order as Map::max_visible_locations
+ * used to generate them. Every step of the algorithm adds its 8 mirrored tiles, so some tiles are in the ring twice.
+ */
+struct Ring
+{
+    std::array< Offset, 8 * ( max_range + 1 ) > offsets;
+    size_t size;
+};
+
+constexpr Ring make_ring( uint32_t range )
+{
+    Ring ring{};
+    ring.size = 0;
+    if ( range == 0 ) return ring;
+
+    // Unsigned like in the original implementation, d wraps around the same way
+    uint32_t d = range - 1;
+    uint32_t a = range - 1;
+    uint32_t b = 0;
+    while ( a >= b ) {
+        const Offset octants[8] = {
+            { int8_t( b ), int8_t( a ) }, { int8_t( a ), int8_t( b ) }, { int8_t( -b ), int8_t( a ) }, { int8_t( -a ), int8_t( b ) },
+            { int8_t( b ), int8_t( -a ) }, { int8_t( a ), int8_t( -b ) }, { int8_t( -b ), int8_t( -a ) }, { int8_t( -a ), int8_t( -b ) }
+        };
+        for ( const Offset& offset : octants ) {
+            ring.offsets[ ring.size++ ] = offset;
+        }
+
+        if ( d >= 2 * b ) {
+            d = d - 2 * b - 1;
+            b = b + 1;
+        }
+        else if ( d < 2 * ( range - a ) ) {
+            d = d + 2 * a - 1;
+            a = a - 1;
+        }
+        else {
+            d = d + 2 * ( a - b - 1 );
+            a = a - 1;
+            b = b + 1;
+        }
+    }
+    return ring;
+}
+
+constexpr std::array< Ring, max_range + 1 > make_rings()
+{
+    std::array< Ring, max_range + 1 > rings{};
+    for ( uint32_t range = 0; range <= max_range; range++ ) {
+        rings[range] = make_ring( range );
+    }
+    return rings;
+}
+
+inline constexpr std::array< Ring, max_range + 1 > rings = make_rings();
+
+/*
+ * The half widths of the rows of the disc the field of view covers: the tile (dx, dy) is within <range> when
+ * dx^2 + dy^2 <= range^2 + range, so row dy of the disc spans the columns -half_width .. half_width.
+ */
+using HalfWidths = std::array< uint8_t, max_range + 1 >;
+
+constexpr HalfWidths make_half_widths( uint32_t range )
+{
+    HalfWidths half_widths{};
+    const int64_t radius_squared = int64_t( range ) * range + range;
+    for ( int64_t dy = 0; dy <= range; dy++ ) {
+        int64_t dx = 0;
+        while ( ( dx + 1 ) * ( dx + 1 ) + dy * dy <= radius_squared ) dx++;
+        half_widths[dy] = uint8_t( dx );
+    }
+    return half_widths;
+}
+
+constexpr std::array< HalfWidths, max_range + 1 > make_disc_half_widths()
+{
+    std::array< HalfWidths, max_range + 1 > discs{};
+    for ( uint32_t range = 0; range <= max_range; range++ ) {
+        discs[range] = make_half_widths( range );
+    }
+    return discs;
+}
+
+inline constexpr std::array< HalfWidths, max_range + 1 > disc_half_widths = make_disc_half_widths();
+
+/**
+ * @brief The half width of row <dy> of the disc of <range>, -1 if the row is outside of the disc. Looked up from the table for
+ * the ranges it covers.
+ */
+inline int64_t disc_half_width( uint32_t range, int64_t dy ) noexcept
+{
+    if ( dy < 0 ) dy = -dy;
+    if ( dy > int64_t( range ) ) return -1;
+    if ( range <= max_range ) return disc_half_widths[range][dy];
+
+    // The square root can be off by one either way because of the rounding
+    const int64_t radius_squared = int64_t( range ) * range + range - dy * dy;
+    int64_t dx = int64_t( std::sqrt( double( radius_squared ) ) );
+    while ( dx * dx > radius_squared ) dx--;
+    while ( ( dx + 1 ) * ( dx + 1 ) <= radius_squared ) dx++;
+    return dx;
+}
+
+} // namespace RangeTables
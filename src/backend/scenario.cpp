@@ -17,8 +17,9 @@ std::shared_ptr<Game> Scenario::generate_game() {
     int enemy_team_id = teams[teams.size() - 1].get_id();
 
 
-    std::vector<Unit>& player_units = game->get_team_by_id(player_team_id).get_units();
-    std::vector<Unit>& enemy_units = game->get_team_by_id(enemy_team_id).get_units();
+    // The units stay at the same address in their team, so the map can point to them
+    SlotMap<Unit>& player_units = game->get_team_by_id(player_team_id).get_units();
+    SlotMap<Unit>& enemy_units = game->get_team_by_id(enemy_team_id).get_units();
 
 
     for (unsigned int i = 0; i < player_units.size(); i++) {
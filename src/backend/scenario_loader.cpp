@@ -92,6 +92,10 @@ Map ScenarioLoader::construct_map() {
         Map_Builder builder = Map_Builder();
         YAML::Node map_node = scenario_["map"];
         Map map = builder.load(map_node["path"].as<std::string>());
+        // Plain A* is fast enough on the small maps, the large ones get an abstract graph for the long paths
+        if (map.width() * map.height() >= large_map_tiles_) {
+            map.enable_hierarchical_pathfinding();
+        }
 
         // load enemy positions, throw error if not enough positions for all enemies
         YAML::Node enemies = map_node["enemies"];
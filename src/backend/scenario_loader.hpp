@@ -29,6 +29,9 @@ private:
 
     std::vector<coordinates<size_t>> enemy_positions_;
     std::vector<coordinates<size_t>> player_positions_;
+
+    // maps with at least this many tiles use hierarchical pathfinding (256x256)
+    static constexpr size_t large_map_tiles_ = 256 * 256;
 };
 
 
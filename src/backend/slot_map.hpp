@@ -0,0 +1,253 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <optional>
+#include <iterator>
+#include <utility>
+#include <type_traits>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <cassert>
+
+
+/**
+ * @brief Refers to an element of a SlotMap. The handle stays valid while the element is in the map, and once the element
+ * is erased the handle no longer finds anything, even if its slot is used again for a new element.
+ */
+struct SlotHandle
+{
+    static constexpr uint32_t invalid_index = UINT32_MAX;
+
+    uint32_t index = invalid_index;
+    uint32_t generation = 0;
+
+    [[nodiscard]]
+    constexpr bool valid() const noexcept
+    {
+        return index != invalid_index;
+    }
+
+    constexpr bool operator == ( const SlotHandle& other ) const noexcept = default;
+};
+
+
+/**
+ * @brief Generational slot map: the elements are looked up by a SlotHandle in O(1), and erasing an element makes its
+ * handles stale instead of handing the element of another insert out through them.
+ *
+ * The slots are allocated in pages that are never moved, so pointers and references to the elements stay valid until
+ * the element is erased, however many elements are inserted or erased around it. Moving the map keeps the elements
+ * where they are. Copying the map copies the elements into the same slots, so handles of the original find the copies.
+ *
+ * Iterating goes through the elements in the order they were inserted, and operator[] gives the element at a position
+ * of that order. Erasing keeps the order, which takes time linear in the amount of elements.
+ */
+template<typename T>
+class SlotMap
+{
+    private:
+        struct Slot
+        {
+            std::optional<T> value;
+            uint32_t generation = 0;
+        };
+
+        static constexpr size_t page_size_ = 64;
+
+        std::vector< std::unique_ptr< Slot[] > > pages_;
+        size_t slot_count_ = 0;
+        std::vector<uint32_t> free_slots_;
+        // the slots of the elements, in the order they were inserted
+        std::vector<uint32_t> order_;
+
+        inline Slot& slot( const uint32_t index ) noexcept
+        {
+            return pages_[index / page_size_][index % page_size_];
+        }
+
+        inline const Slot& slot( const uint32_t index ) const noexcept
+        {
+            return pages_[index / page_size_][index % page_size_];
+        }
+
+        template<bool Const>
+        class Iterator
+        {
+            using Map = std::conditional_t< Const, const SlotMap, SlotMap >;
+
+            Map* map_ = nullptr;
+            size_t position_ = 0;
+
+            public:
+                using iterator_category = std::forward_iterator_tag;
+                using value_type = T;
+                using difference_type = std::ptrdiff_t;
+                using pointer = std::conditional_t< Const, const T*, T* >;
+                using reference = std::conditional_t< Const, const T&, T& >;
+
+                Iterator() noexcept = default;
+                Iterator( Map* map, size_t position ) noexcept : map_(map), position_(position) { }
+
+                inline reference operator * () const noexcept
+                {
+                    return ( *map_ )[position_];
+                }
+
+                inline pointer operator -> () const noexcept
+                {
+                    return &( *map_ )[position_];
+                }
+
+                inline Iterator& operator ++ () noexcept
+                {
+                    position_++;
+                    return *this;
+                }
+
+                inline Iterator operator ++ ( int ) noexcept
+                {
+                    Iterator previous = *this;
+                    position_++;
+                    return previous;
+                }
+
+                inline bool operator == ( const Iterator& other ) const noexcept
+                {
+                    return position_ == other.position_;
+                }
+        };
+
+    public:
+        using iterator = Iterator<false>;
+        using const_iterator = Iterator<true>;
+
+        SlotMap() noexcept = default;
+        SlotMap( SlotMap&& ) noexcept = default;
+        SlotMap& operator = ( SlotMap&& ) noexcept = default;
+
+        SlotMap( const SlotMap& other ) :
+            slot_count_(other.slot_count_), free_slots_(other.free_slots_), order_(other.order_)
+        {
+            for ( const std::unique_ptr< Slot[] >& page : other.pages_ ) {
+                pages_.push_back( std::make_unique< Slot[] >( page_size_ ) );
+                std::copy( page.get(), page.get() + page_size_, pages_.back().get() );
+            }
+        }
+
+        SlotMap& operator = ( const SlotMap& other )
+        {
+            if ( this != &other ) *this = SlotMap( other );
+            return *this;
+        }
+
+        /**
+         * @brief Adds the element, reusing the slot of an erased element if there is one
+         *
+         * @return SlotHandle the handle of the new element
+         */
+        SlotHandle insert( T value )
+        {
+            uint32_t index;
+            if ( !free_slots_.empty() ) {
+                index = free_slots_.back();
+                free_slots_.pop_back();
+            } else {
+                if ( slot_count_ == pages_.size() * page_size_ ) pages_.push_back( std::make_unique< Slot[] >( page_size_ ) );
+                index = slot_count_++;
+            }
+
+            Slot& s = slot( index );
+            s.value.emplace( std::move( value ) );
+            order_.push_back( index );
+            return { index, s.generation };
+        }
+
+        /**
+         * @brief Removes the element of the handle, its handles don't find anything after this
+         *
+         * @return bool false if the handle was already stale
+         */
+        bool erase( const SlotHandle& handle )
+        {
+            if ( get( handle ) == nullptr ) return false;
+
+            Slot& s = slot( handle.index );
+            s.value.reset();
+            s.generation++;
+            free_slots_.push_back( handle.index );
+            order_.erase( std::find( order_.begin(), order_.end(), handle.index ) );
+            return true;
+        }
+
+        /**
+         * @brief The element of the handle, nullptr if it has been erased
+         */
+        [[nodiscard]]
+        inline T* get( const SlotHandle& handle ) noexcept
+        {
+            return const_cast<T*>( std::as_const( *this ).get( handle ) );
+        }
+
+        [[nodiscard]]
+        inline const T* get( const SlotHandle& handle ) const noexcept
+        {
+            if ( handle.index >= slot_count_ ) return nullptr;
+            const Slot& s = slot( handle.index );
+            return s.generation == handle.generation && s.value.has_value() ? &*s.value : nullptr;
+        }
+
+        [[nodiscard]]
+        inline bool contains( const SlotHandle& handle ) const noexcept
+        {
+            return get( handle ) != nullptr;
+        }
+
+        /**
+         * @brief The handle of the element at <position> of the insertion order
+         */
+        [[nodiscard]]
+        inline SlotHandle handle_at( const size_t position ) const noexcept
+        {
+            assert( position < order_.size() );
+            return { order_[position], slot( order_[position] ).generation };
+        }
+
+        [[nodiscard]]
+        inline T& operator [] ( const size_t position ) noexcept
+        {
+            assert( position < order_.size() );
+            return *slot( order_[position] ).value;
+        }
+
+        [[nodiscard]]
+        inline const T& operator [] ( const size_t position ) const noexcept
+        {
+            assert( position < order_.size() );
+            return *slot( order_[position] ).value;
+        }
+
+        [[nodiscard]]
+        inline T& front() noexcept { return ( *this )[0]; }
+
+        [[nodiscard]]
+        inline const T& front() const noexcept { return ( *this )[0]; }
+
+        [[nodiscard]]
+        inline T& back() noexcept { return ( *this )[order_.size() - 1]; }
+
+        [[nodiscard]]
+        inline const T& back() const noexcept { return ( *this )[order_.size() - 1]; }
+
+        [[nodiscard]]
+        inline size_t size() const noexcept { return order_.size(); }
+
+        [[nodiscard]]
+        inline bool empty() const noexcept { return order_.empty(); }
+
+        inline iterator begin() noexcept { return iterator( this, 0 ); }
+        inline iterator end() noexcept { return iterator( this, order_.size() ); }
+        inline const_iterator begin() const noexcept { return const_iterator( this, 0 ); }
+        inline const_iterator end() const noexcept { return const_iterator( this, order_.size() ); }
+};
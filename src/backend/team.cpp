@@ -28,16 +28,20 @@ std::shared_ptr<Action> Team::dequeue_action() {
     return first;
 }
 
-void Team::add_unit(Unit unit) {
-    units_.push_back(std::move(unit));
+UnitHandle Team::add_unit(Unit unit) {
+    const int id = unit.get_id();
+    const SlotHandle slot = units_.insert(std::move(unit));
+    Unit& added = *units_.get(slot);
+    added.handle_ = {team_id_, slot};
+    handles_[id] = slot;
+    return added.handle_;
 }
 
 bool Team::remove_unit(int id) {
-    auto it = std::find_if(units_.begin(), units_.end(), [id](const Unit& unit) {
-        return unit.get_id() == id;
-    });
-    if (it != units_.end()) {
-        units_.erase(it);
+    auto it = handles_.find(id);
+    if (it != handles_.end()) {
+        units_.erase(it->second);
+        handles_.erase(it);
         return true;
     }
 
@@ -45,25 +49,37 @@ bool Team::remove_unit(int id) {
 }
 
 Unit* Team::get_unit(int id) {
-    auto it = std::find_if(units_.begin(), units_.end(), [id](const Unit& unit) {
-        return unit.get_id() == id;
-    });
-
-    if (it != units_.end()) {
-        return &*it;
+    auto it = handles_.find(id);
+    if (it != handles_.end()) {
+        return units_.get(it->second);
     }
 
-    //should not be reached
-    //assert(false);
     return nullptr;
 }
 
+Unit* Team::get_unit(const UnitHandle& handle) {
+    if (handle.team_id != team_id_) return nullptr;
+    return units_.get(handle.slot);
+}
+
+UnitHandle Team::get_handle(int id) const {
+    auto it = handles_.find(id);
+    if (it != handles_.end()) {
+        return {team_id_, it->second};
+    }
+
+    return {};
+}
+
+bool Team::has_unit(int id) const {
+    return handles_.find(id) != handles_.end();
+}
 
-std::vector<Unit>& Team::get_units() {
+SlotMap<Unit>& Team::get_units() {
     return units_;
 }
 
-const std::vector<Unit>& Team::get_units() const {
+const SlotMap<Unit>& Team::get_units() const {
     return units_;
 }
 
@@ -87,5 +103,5 @@ int Team::get_id() const {
 }
 
 bool Team::all_dead() const {
-    return (std::all_of(units_.begin(),units_.end(),[](Unit unit) {return unit.is_dead();}));
+    return (std::all_of(units_.begin(),units_.end(),[](const Unit& unit) {return unit.is_dead();}));
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include <vector>
 #include <deque>
+#include <unordered_map>
 
 #include "action.hpp"
 #include "unit.hpp"
@@ -14,6 +15,12 @@ public:
         id_count_++;
     }
 
+    // Moving a team leaves its units where they are, so the pointers to them stay valid when the teams of a game are moved
+    Team(const Team&) = default;
+    Team(Team&&) noexcept = default;
+    Team& operator=(const Team&) = default;
+    Team& operator=(Team&&) noexcept = default;
+
     // Add turn to be executed to the queue
     void enqueue_action(std::shared_ptr<Action> action);
 
@@ -24,27 +31,37 @@ public:
     [[nodiscard]]
     std::shared_ptr<Action> dequeue_action();
 
-    //add Unit to the team
-    void add_unit(Unit unit);
+    //add Unit to the team, the unit stays at the same address until it is removed
+    UnitHandle add_unit(Unit unit);
 
-    //Remove unit by id, return true if worked, false if unit didn't exist
+    //Remove unit by id, return true if worked, false if unit didn't exist. The handles of the unit don't find it after this
     bool remove_unit(int id);
 
     //Get unit by id, pointer since unit by that id might not exist
     Unit* get_unit(int id);
 
+    //Get unit by handle, nullptr if the unit has been removed or the handle is of another team
+    Unit* get_unit(const UnitHandle& handle);
+
+    //The handle of the unit with the id, not valid if the team doesn't have it
+    [[nodiscard]]
+    UnitHandle get_handle(int id) const;
+
+    [[nodiscard]]
+    bool has_unit(int id) const;
+
     bool all_dead() const;
 
-    //return reference to units vector
+    //return reference to the units, in the order they were added
     [[nodiscard]]
-    std::vector<Unit>& get_units();
+    SlotMap<Unit>& get_units();
 
     [[nodiscard]]
     std::vector<Unit*> get_alive_units();
 
     //const version of get_units
     [[nodiscard]]
-    const std::vector<Unit>& get_units() const;
+    const SlotMap<Unit>& get_units() const;
 
     //return the amount of Units on this team
     [[nodiscard]]
@@ -55,7 +72,9 @@ public:
     int get_id() const;
 
 private:
-    std::vector<Unit> units_;
+    SlotMap<Unit> units_;
+    // the handles of the units by their id
+    std::unordered_map<int, SlotHandle> handles_;
     std::deque<std::shared_ptr<Action>> turns_;
     int team_id_;
 
@@ -0,0 +1,104 @@
+#include <bit>
+
+#include "team_visibility.hpp"
+#include "map.hpp"
+#include "unit.hpp"
+#include "thread_pool.hpp"
+
+
+void TeamVisibility::calculate_view( Map& map, UnitView& view ) const {
+    view.tiles.clear();
+    for ( const coordinates<size_t>& coords : map.tiles_unit_sees( view.location, view.range ) ) {
+        view.tiles.push_back( coords.y * width_ + coords.x );
+    }
+}
+
+
+void TeamVisibility::add_view( const UnitView& view ) {
+    for ( uint32_t idx : view.tiles ) {
+        if ( counts_[idx]++ == 0 ) visible_.set( idx / width_, idx % width_ );
+    }
+}
+
+
+void TeamVisibility::remove_view( const UnitView& view ) {
+    for ( uint32_t idx : view.tiles ) {
+        if ( --counts_[idx] == 0 ) visible_.reset( idx / width_, idx % width_ );
+    }
+}
+
+
+void TeamVisibility::update( Map& map, const std::vector<Unit*>& units, uint32_t range, ThreadPool* pool ) {
+    update_++;
+
+    // The views depend on the terrain, so when it has changed everything is recalculated
+    if ( map.terrain_version() != terrain_version_ || map.width() != width_ || map.height() != height_ ) {
+        width_ = map.width();
+        height_ = map.height();
+        terrain_version_ = map.terrain_version();
+        counts_.assign( width_ * height_, 0 );
+        visible_ = BitGrid( height_, width_ );
+        unit_views_.clear();
+        version_++;
+    }
+
+    // The units that were added or moved, their old views are removed right away and the new ones calculated below
+    std::vector< UnitView* > changed;
+    for ( const Unit* unit : units ) {
+        const coordinates<size_t> location = map.get_unit_location( unit );
+        auto [it, added] = unit_views_.try_emplace( unit, UnitView{ location, range, {}, update_ } );
+        UnitView& view = it->second;
+        view.update = update_;
+
+        if ( added ) {
+            changed.push_back( &view );
+        } else if ( view.location != location || view.range != range ) {
+            // Only the view of a unit that moved changes
+            remove_view( view );
+            view.location = location;
+            view.range = range;
+            changed.push_back( &view );
+        }
+    }
+
+    if ( pool != nullptr && changed.size() >= parallel_threshold ) {
+        pool->parallel_for( changed.size(), [&]( size_t index, size_t ) { calculate_view( map, *changed[index] ); } );
+    } else {
+        for ( UnitView* view : changed ) {
+            calculate_view( map, *view );
+        }
+    }
+    for ( const UnitView* view : changed ) {
+        add_view( *view );
+    }
+    if ( !changed.empty() ) version_++;
+
+    // Units that weren't in the team this time
+    for ( auto it = unit_views_.begin(); it != unit_views_.end(); ) {
+        if ( it->second.update != update_ ) {
+            remove_view( it->second );
+            it = unit_views_.erase( it );
+            version_++;
+        } else {
+            ++it;
+        }
+    }
+}
+
+
+const std::vector< coordinates<size_t> >& TeamVisibility::visible_tiles() {
+    if ( visible_tiles_version_ == version_ ) return visible_tiles_;
+
+    // Going through the bits in row-major order gives the tiles sorted and without duplicates
+    visible_tiles_.clear();
+    for ( size_t y = 0; y < height_; y++ ) {
+        const uint64_t* words = visible_.row( y );
+        for ( size_t i = 0; i < visible_.words_per_row(); i++ ) {
+            for ( uint64_t word = words[i]; word != 0; word &= word - 1 ) {
+                visible_tiles_.emplace_back( i * 64 + std::countr_zero( word ), y );
+            }
+        }
+    }
+    visible_tiles_version_ = version_;
+    return visible_tiles_;
+}
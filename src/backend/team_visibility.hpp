@@ -0,0 +1,100 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <unordered_map>
+
+#include "coordinates.hpp"
+#include "bit_grid.hpp"
+
+class Map;
+class Unit;
+class ThreadPool;
+
+
+/**
+ * @brief The tiles a team sees, kept up to date incrementally. Every tile has a counter of how many of the
+ * team's units see it and every unit's view is stored, so when a unit moves only its old view is subtracted
+ * and its new view added. Everything is recalculated only when the terrain of the map changes.
+ */
+class TeamVisibility
+{
+    public:
+        TeamVisibility() = default;
+
+        // The views are only calculated on the threads of a pool when at least this many units need a new view
+        static const size_t parallel_threshold = 16;
+
+        /**
+         * @brief Brings the visibility up to date with the units' current locations. Units that aren't in <units>
+         * anymore (died) have their view removed.
+         *
+         * @param map the map the units are on
+         * @param units the units of the team that see
+         * @param range the visual range of the units
+         * @param pool threads to calculate the new views on, every unit's view is stored separately and added to the counts
+         * afterwards, so the result is the same as without a pool
+         */
+        void update( Map& map, const std::vector<Unit*>& units, uint32_t range, ThreadPool* pool = nullptr );
+
+        [[nodiscard]]
+        inline bool is_visible( size_t y, size_t x ) const noexcept
+        {
+            return visible_.test( y, x );
+        }
+
+        /**
+         * @brief The visible tiles as bits, a bit is set when the count of the tile is above 0
+         */
+        [[nodiscard]]
+        inline const BitGrid& visible_grid() const noexcept
+        {
+            return visible_;
+        }
+
+        /**
+         * @brief Incremented every time the visible tiles change
+         */
+        [[nodiscard]]
+        inline size_t version() const noexcept
+        {
+            return version_;
+        }
+
+        /**
+         * @brief The visible tiles in sorted order without duplicates. Only recalculated after the visibility has changed.
+         */
+        const std::vector< coordinates<size_t> >& visible_tiles();
+
+    private:
+        struct UnitView
+        {
+            coordinates<size_t> location;
+            uint32_t range;
+            // tile indices (y * width + x) the unit sees
+            std::vector<uint32_t> tiles;
+            // the update in which the unit was last seen in the team
+            size_t update;
+        };
+
+        size_t width_ = 0;
+        size_t height_ = 0;
+        // amount of units that see each tile
+        std::vector<uint16_t> counts_;
+        BitGrid visible_;
+        std::unordered_map< const Unit*, UnitView > unit_views_;
+
+        // terrain version of the map the views were calculated on, SIZE_MAX before the first update
+        size_t terrain_version_ = SIZE_MAX;
+        size_t update_ = 0;
+        size_t version_ = 0;
+
+        std::vector< coordinates<size_t> > visible_tiles_;
+        size_t visible_tiles_version_ = SIZE_MAX;
+
+        // calculates the tiles of the view, doesn't touch the counts so it can be called from several threads
+        void calculate_view( Map& map, UnitView& view ) const;
+        void add_view( const UnitView& view );
+        void remove_view( const UnitView& view );
+};
@@ -0,0 +1,97 @@
+#include <algorithm>
+
+#include "thread_pool.hpp"
+
+
+ThreadPool::ThreadPool( size_t jobs ) {
+    if ( jobs == 0 ) jobs = std::max<size_t>( std::thread::hardware_concurrency(), 1 );
+    workers_.reserve( jobs - 1 );
+    for ( size_t job = 1; job < jobs; job++ ) {
+        workers_.emplace_back( &ThreadPool::worker_loop, this, job );
+    }
+}
+
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock( mutex_ );
+        stopping_ = true;
+    }
+    start_.notify_all();
+    for ( std::thread& worker : workers_ ) {
+        worker.join();
+    }
+}
+
+
+void ThreadPool::work( size_t job ) {
+    // Small chunks keep the jobs busy when some items take longer than others
+    const size_t chunk = std::max<size_t>( 1, count_ / ( jobs() * 8 ) );
+    while ( true ) {
+        const size_t first = next_index_.fetch_add( chunk );
+        if ( first >= count_ ) return;
+
+        const size_t last = std::min( first + chunk, count_ );
+        try {
+            for ( size_t index = first; index < last; index++ ) {
+                ( *func_ )( index, job );
+            }
+        } catch ( ... ) {
+            std::lock_guard<std::mutex> lock( mutex_ );
+            if ( !error_ ) error_ = std::current_exception();
+            next_index_ = count_;
+            return;
+        }
+    }
+}
+
+
+void ThreadPool::worker_loop( size_t job ) {
+    size_t seen_generation = 0;
+    while ( true ) {
+        {
+            std::unique_lock<std::mutex> lock( mutex_ );
+            start_.wait( lock, [&] { return stopping_ || generation_ != seen_generation; } );
+            if ( stopping_ ) return;
+            seen_generation = generation_;
+        }
+
+        work( job );
+
+        {
+            std::lock_guard<std::mutex> lock( mutex_ );
+            busy_workers_--;
+        }
+        done_.notify_one();
+    }
+}
+
+
+void ThreadPool::parallel_for( size_t count, const std::function<void( size_t index, size_t job )>& func ) {
+    if ( count == 0 ) return;
+
+    if ( workers_.empty() || count == 1 ) {
+        for ( size_t index = 0; index < count; index++ ) {
+            func( index, 0 );
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock( mutex_ );
+        func_ = &func;
+        count_ = count;
+        next_index_ = 0;
+        error_ = nullptr;
+        busy_workers_ = workers_.size();
+        generation_++;
+    }
+    start_.notify_all();
+
+    work( 0 );
+
+    std::unique_lock<std::mutex> lock( mutex_ );
+    done_.wait( lock, [&] { return busy_workers_ == 0; } );
+    func_ = nullptr;
+    if ( error_ ) std::rethrow_exception( error_ );
+}
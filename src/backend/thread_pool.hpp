@@ -0,0 +1,67 @@
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <exception>
+#include <cstddef>
+
+
+/**
+ * @brief A fixed set of worker threads for splitting loops over independent items, like the field of view of every unit.
+ * The thread calling parallel_for takes part in the work too, so a pool of 1 job has no worker threads and runs
+ * everything on the calling thread.
+ *
+ * The items are handed out to the jobs in small chunks as they finish, so which job handles which item changes
+ * from run to run. Callers that need deterministic results should write the result of every item into its own
+ * slot, or combine the per-job results with an operation where the order doesn't matter.
+ */
+class ThreadPool
+{
+    public:
+        /**
+         * @param jobs the amount of threads working on a loop, including the calling thread. 0 uses the amount of hardware threads.
+         */
+        explicit ThreadPool( size_t jobs = 0 );
+        ~ThreadPool();
+
+        ThreadPool( const ThreadPool& ) = delete;
+        ThreadPool& operator = ( const ThreadPool& ) = delete;
+
+        [[nodiscard]]
+        inline size_t jobs() const noexcept
+        {
+            return workers_.size() + 1;
+        }
+
+        /**
+         * @brief Calls <func>(index, job) for every index in [0, count) and returns when all of them are done.
+         * <job> is in [0, jobs()) and no two calls with the same job run at the same time, so it can be used to pick
+         * a per-job buffer. If a call throws, the rest of the items are skipped and the first exception is rethrown.
+         * Only one loop can run at a time, parallel_for can't be called from inside of <func>.
+         */
+        void parallel_for( size_t count, const std::function<void( size_t index, size_t job )>& func );
+
+    private:
+        std::vector< std::thread > workers_;
+
+        std::mutex mutex_;
+        std::condition_variable start_;
+        std::condition_variable done_;
+        // incremented every time a loop starts, the workers wait for it to change
+        size_t generation_ = 0;
+        bool stopping_ = false;
+        size_t busy_workers_ = 0;
+
+        // the loop that is running
+        const std::function<void( size_t, size_t )>* func_ = nullptr;
+        size_t count_ = 0;
+        std::atomic<size_t> next_index_ = 0;
+        std::exception_ptr error_;
+
+        void work( size_t job );
+        void worker_loop( size_t job );
+};
@@ -6,6 +6,7 @@
 #include <memory>
 
 #include "item.hpp"
+#include "slot_map.hpp"
 
 /** Constant values used for initializing Unit instances.
  */
@@ -18,6 +19,23 @@ struct {
 } unit_consts;
 
 
+/** Refers to a unit of a team, see Game::get_unit(const UnitHandle&). The handle stops finding the unit when the
+ *  unit is removed from its team, so it can be kept around where a pointer to the unit could be left dangling.
+ */
+struct UnitHandle
+{
+    int team_id = -1;
+    SlotHandle slot;
+
+    [[nodiscard]]
+    bool valid() const {
+        return slot.valid();
+    }
+
+    bool operator==(const UnitHandle& other) const = default;
+};
+
+
 /** Unit class. This class represents playable units in the game.
  *  Each unit has an HP value, an inventory consisting of up to unit_consts.inventory_size Item pointers, and a unique ID as well as a name.
  */
@@ -36,6 +54,11 @@ public:
         return id_;
     }
 
+    // The handle of the unit in its team, not valid if the unit hasn't been added to a team
+    const UnitHandle& get_handle() const {
+        return handle_;
+    }
+
     const std::vector<std::shared_ptr<const Item>>& get_inventory() const {
         return inventory_;
     }
@@ -95,6 +118,10 @@ private:
     int current_hp_;
 
     unsigned int id_;
+    UnitHandle handle_;
 
     static inline unsigned int count_ = 0;
+
+    // Team sets the handle when the unit is added to it
+    friend class Team;
 };
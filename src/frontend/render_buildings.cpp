@@ -20,18 +20,18 @@ void Render_Buildings::update() {
 
 void Render_Buildings::update_sprite_map() {
     Map& map = tile_map_->get_map();
-    std::vector<std::shared_ptr<Building>> all_buildings = map.get_all_buildings();
-    //If no new buildings have appeared then return.
-    if (all_buildings.size() == building_sprite_map_.size()) return;
+    //If no buildings have been built or removed then return.
+    if (buildings_version_ == map.buildings_version()) return;
+    buildings_version_ = map.buildings_version();
 
     //Otherwise initialize sprites for every building in map.
     building_sprite_map_.clear();
     int textW = buildings_text.getSize().y;
     double scale = tile_map_->get_TileDim() / textW;
     
-    for (auto& building : all_buildings) {
-        building_sprite_map_[building] = sf::Sprite();
-        sf::Sprite& sprite = building_sprite_map_[building];
+    for (const Map::BuildingEntry& entry : map.get_building_entries()) {
+        building_sprite_map_[entry.building] = sf::Sprite();
+        sf::Sprite& sprite = building_sprite_map_[entry.building];
         sprite.setTexture(buildings_text);
         sprite.setScale(scale,scale);
     }
@@ -44,16 +44,20 @@ void Render_Buildings::update_building_positions_and_textures() {
     Map& map = tile_map_->get_map();
     int textW = buildings_text.getSize().y;
 
-    for (auto& building_spr : building_sprite_map_) {
-        coordinates<size_t> coords = map.get_building_location(building_spr.first);
+    for (const Map::BuildingEntry& entry : map.get_building_entries()) {
+        const coordinates<size_t>& coords = entry.location;
         if (!tile_map_->is_inside_map_tile(coords)) continue; //If somehow given invalid coords then continue.
 
-        int text_idx = (tile_map_->is_tile_drawn(coords)) ? building_spr.first->get_texture_idx() : 0;
+        auto sprite_it = building_sprite_map_.find(entry.building);
+        if (sprite_it == building_sprite_map_.end()) continue;
+        sf::Sprite& sprite = sprite_it->second;
+
+        int text_idx = (tile_map_->is_tile_drawn(coords)) ? entry.building->get_texture_idx() : 0;
         sf::Vector2i spr_coords = sf::Vector2i(coords.x*tileDim,coords.y*tileDim);
         //Make sure that building position is up to date.
-        building_spr.second.setPosition(x0y0.first+spr_coords.x,x0y0.second+spr_coords.y);
+        sprite.setPosition(x0y0.first+spr_coords.x,x0y0.second+spr_coords.y);
         //Make sure that building sprite is up to date.
-        building_spr.second.setTextureRect(sf::IntRect(textW*text_idx,0,textW,textW));
+        sprite.setTextureRect(sf::IntRect(textW*text_idx,0,textW,textW));
     }
     return;
 }
@@ -10,6 +10,7 @@
 #include <vector>
 #include <string>
 #include <unordered_map>
+#include <limits>
 
 
 /**
@@ -39,6 +40,7 @@ public:
 private:
     std::shared_ptr<Tile_Map> tile_map_;
     std::unordered_map<std::shared_ptr<Building>,sf::Sprite> building_sprite_map_; //Connects a building ptr to a sprite.
+    size_t buildings_version_ = std::numeric_limits<size_t>::max(); //Map's buildings version that building_sprite_map_ was built from.
     sf::Texture buildings_text; //Contains all textures for buildings. Initialized on load.
     
     /**
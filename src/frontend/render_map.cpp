@@ -1,3 +1,5 @@
+#include <bit>
+
 #include "render_map.hpp"
 
 Render_Map::Render_Map(std::shared_ptr<Tile_Map>& tile_map) : tile_map_(tile_map) { }
@@ -16,7 +18,6 @@ bool Render_Map::load(const std::string& tiles) {
 
 void Render_Map::update_tile_position_and_textures() {
     Map& map = tile_map_->get_map();
-    int texW = tile_texture_.getSize().y;
 
     int mapWidth = map.width();
     int mapHeight = map.height();
@@ -25,13 +26,15 @@ void Render_Map::update_tile_position_and_textures() {
     int tileDim = tile_map_->get_TileDim();
     float x0 = x0y0.first;
     float y0 = x0y0.second;
+    drawn_visibility_version_ = tile_map_->visibility_version();
+    drawn_terrain_version_ = map.terrain_version();
+    drawn_x0y0_ = x0y0;
+    drawn_fog_of_war_ = tile_map_->fog_of_war;
+    needs_full_redraw_ = false;
     //This implementation follows pretty closely sfml tutorial made with triangles instead of quads:
     //https://www.sfml-dev.org/tutorials/2.6/graphics-vertex-array.php
     for (int i = 0; i <  mapWidth; i++) {
         for (int j = 0; j < mapHeight; j++) {
-            int32_t tile = (tile_map_->is_tile_drawn(i, j)) ? map.get_terrain(j,i)->texture() : 0;
-            int texture_x = tile % (tile_texture_.getSize().x / tile_texture_.getSize().y);
-            int texture_y = tile / (tile_texture_.getSize().x / tile_texture_.getSize().y);
             int tile_idx = (i*mapHeight+j)*4;
             //Setting up vertex positions.
             tile_VertexArr_[tile_idx + 0].position = sf::Vector2f(x0 + tileDim * i,y0 + tileDim * j);
@@ -39,20 +42,66 @@ void Render_Map::update_tile_position_and_textures() {
             tile_VertexArr_[tile_idx + 2].position = sf::Vector2f(x0 + tileDim * (i+1),y0 + tileDim * (j+1));
             tile_VertexArr_[tile_idx + 3].position = sf::Vector2f(x0 + tileDim * i,y0 + tileDim * (j+1));                
             //Setting up textures.
-            tile_VertexArr_[tile_idx + 0].texCoords = sf::Vector2f(texW * texture_x,texW * texture_y);
-            tile_VertexArr_[tile_idx + 1].texCoords = sf::Vector2f(texW * (texture_x+1),texW * texture_y);
-            tile_VertexArr_[tile_idx + 2].texCoords = sf::Vector2f(texW * (texture_x+1),texW * (texture_y+1));
-            tile_VertexArr_[tile_idx + 3].texCoords = sf::Vector2f(texW * texture_x,texW * (texture_y+1));
+            update_tile_texture(i, j);
+        }
+    }
+    return;
+}
+
+void Render_Map::update_tile_texture(int i, int j) {
+    Map& map = tile_map_->get_map();
+    int texW = tile_texture_.getSize().y;
+    int mapHeight = map.height();
+
+    int32_t tile = (tile_map_->is_tile_drawn(i, j)) ? map.get_terrain(j,i)->texture() : 0;
+    int texture_x = tile % (tile_texture_.getSize().x / tile_texture_.getSize().y);
+    int texture_y = tile / (tile_texture_.getSize().x / tile_texture_.getSize().y);
+    int tile_idx = (i*mapHeight+j)*4;
+    tile_VertexArr_[tile_idx + 0].texCoords = sf::Vector2f(texW * texture_x,texW * texture_y);
+    tile_VertexArr_[tile_idx + 1].texCoords = sf::Vector2f(texW * (texture_x+1),texW * texture_y);
+    tile_VertexArr_[tile_idx + 2].texCoords = sf::Vector2f(texW * (texture_x+1),texW * (texture_y+1));
+    tile_VertexArr_[tile_idx + 3].texCoords = sf::Vector2f(texW * texture_x,texW * (texture_y+1));
+    return;
+}
+
+void Render_Map::update_changed_fog() {
+    //Only goes through the set bits of the changed tiles, a word at a time.
+    const BitGrid& changes = tile_map_->visibility_changes();
+    for (size_t y = 0; y < changes.height(); y++) {
+        const uint64_t* words = changes.row(y);
+        for (size_t w = 0; w < changes.words_per_row(); w++) {
+            for (uint64_t word = words[w]; word != 0; word &= word - 1) {
+                update_tile_texture(w * 64 + std::countr_zero(word), y);
+            }
         }
     }
+    drawn_visibility_version_ = tile_map_->visibility_version();
     return;
 }
 
 void Render_Map::update() {
+    //The vertices only change when the map is moved, the terrain changes or different tiles are visible.
+    size_t visibility_version = tile_map_->visibility_version();
+    size_t terrain_version = tile_map_->get_map().terrain_version();
+    std::pair<float,float> x0y0 = tile_map_->get_x0y0();
+    if (!needs_full_redraw_ && terrain_version == drawn_terrain_version_ && x0y0 == drawn_x0y0_ && tile_map_->fog_of_war == drawn_fog_of_war_) {
+        if (visibility_version == drawn_visibility_version_) {
+            return;
+        }
+        //If the visibility changed once since the last update, only the textures of the changed tiles are set up again.
+        if (visibility_version == drawn_visibility_version_ + 1) {
+            update_changed_fog();
+            return;
+        }
+    }
     update_tile_position_and_textures();
     return;
 }
 
 std::weak_ptr<Tile_Map> Render_Map::get_tile_map() { return tile_map_; }
 
-void Render_Map::set_tile_map(std::shared_ptr<Tile_Map>& tile_map) { tile_map_ = tile_map; return; }
+void Render_Map::set_tile_map(std::shared_ptr<Tile_Map>& tile_map) {
+    tile_map_ = tile_map;
+    needs_full_redraw_ = true; //The vertices have to be set up again for the new map.
+    return;
+}
@@ -2,6 +2,8 @@
 #define RENDER_MAP
 
 #include <memory>
+#include <cstdint>
+#include <utility>
 
 #include "map.hpp"
 #include "SFML/Graphics.hpp"
@@ -31,7 +33,8 @@ public:
     bool load(const std::string& tiles);
 
     /**
-     * @brief Used to keep positions of all sprites and text objects up to date. This needs to be called on every tick.
+     * @brief Used to keep positions of all sprites and text objects up to date. This needs to be called on every tick,
+     * but the vertices are only set up again when the map has moved, the terrain has changed or the visible tiles have changed.
      */
     void update() override;
 
@@ -42,12 +45,28 @@ private:
     sf::VertexArray tile_VertexArr_; //VertexArray that will be drawn.
     sf::Texture tile_texture_; //Contains the texture,
     std::shared_ptr<Tile_Map> tile_map_;
+    //What the vertices were last set up with, update() skips setting them up again if nothing has changed.
+    size_t drawn_visibility_version_ = 0;
+    size_t drawn_terrain_version_ = 0;
+    bool needs_full_redraw_ = true; //Set until the vertices have been set up for the current map.
+    std::pair<float,float> drawn_x0y0_;
+    bool drawn_fog_of_war_ = true;
 
     /**
      * @brief Sets up the positions and textures for each vertex in tile_VertexArr.
      */
     void update_tile_position_and_textures();
 
+    /**
+     * @brief Sets up the texture of the tile in column i and row j, hidden tiles get the fog texture.
+     */
+    void update_tile_texture(int i, int j);
+
+    /**
+     * @brief Sets up the textures of the tiles whose visibility changed since the last update.
+     */
+    void update_changed_fog();
+
     /**
      * Inherited method from parent classes.
      */
@@ -9,53 +9,74 @@ bool Render_Units::load(const std::string& unit_texture_path) {
     }
 
     Game& game = *tile_map_->get_game().lock();
-    std::pair<int,int> x0y0 = tile_map_->get_x0y0();
-    int tileDim = tile_map_->get_TileDim();
     int text_idx = 1;
-    int textW = unit_text.getSize().y;
-    double scale = tileDim / textW;
-
-    //Creating a sprite for each unit.
     for (auto& team : game.get_teams()) {
         team_id_text_idx_map_[team.get_id()] = text_idx;
         text_idx++;
-        for (auto& unit : team.get_units()) {
-            unit_sprite_map_[&unit] = sf::Sprite();
-            sf::Sprite& sprite = unit_sprite_map_[&unit];
-            sprite.setOrigin(x0y0.first,x0y0.second);
-            sprite.setTexture(unit_text);
-            sprite.setScale(scale,scale);
-        }
     }
+    update_unit_sprites();
     update_unit_positions_and_textures();
     return true;
 }
 
 void Render_Units::update() {
+    update_unit_sprites();
     update_unit_positions_and_textures();
     return;
 }
 
+void Render_Units::update_unit_sprites() {
+    Game& game = *tile_map_->get_game().lock();
+    std::pair<int,int> x0y0 = tile_map_->get_x0y0();
+    int tileDim = tile_map_->get_TileDim();
+    int textW = unit_text.getSize().y;
+    double scale = tileDim / textW;
+
+    //Creating a sprite for each unit that doesn't have one.
+    for (auto& team : game.get_teams()) {
+        for (auto& unit : team.get_units()) {
+            if (unit_sprite_map_.count(unit.get_id()) != 0) continue;
+            Unit_Sprite& unit_sprite = unit_sprite_map_[unit.get_id()];
+            unit_sprite.handle = unit.get_handle();
+            unit_sprite.sprite.setOrigin(x0y0.first,x0y0.second);
+            unit_sprite.sprite.setTexture(unit_text);
+            unit_sprite.sprite.setScale(scale,scale);
+        }
+    }
+
+    //Removing the sprites of units that are gone.
+    for (auto it = unit_sprite_map_.begin(); it != unit_sprite_map_.end();) {
+        if (game.get_unit(it->second.handle) == nullptr) {
+            it = unit_sprite_map_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
 void Render_Units::update_unit_positions_and_textures() {
+    Game& game = *tile_map_->get_game().lock();
     Map& map = tile_map_->get_map();
     std::pair<int,int> x0y0 = tile_map_->get_x0y0();
     int tileDim = tile_map_->get_TileDim();
 
     for (auto& unit_spr : unit_sprite_map_) {
+        Unit* unit = game.get_unit(unit_spr.second.handle);
+        sf::Sprite& sprite = unit_spr.second.sprite;
+
         //Update postion.
-        coordinates<size_t> coords = map.get_unit_location(unit_spr.first);
+        coordinates<size_t> coords = map.get_unit_location(unit);
         std::pair<int,int> pixel_coords = tile_map_->get_tile_coords(coords.y,coords.x);
         sf::Vector2i spr_coords = sf::Vector2i(coords.x*tileDim,coords.y*tileDim);
-        unit_spr.second.setPosition(x0y0.first+spr_coords.x,x0y0.second+spr_coords.y);
+        sprite.setPosition(x0y0.first+spr_coords.x,x0y0.second+spr_coords.y);
 
         //Update texture.
         int text_idx = 0;
         int textW = unit_text.getSize().y;
         if (tile_map_->is_tile_drawn(coords)) {
-            int unit_team_id = tile_map_->get_game().lock()->get_unit_team_id(unit_spr.first->get_id());
-            text_idx = (unit_spr.first->is_dead()) ? 3 : team_id_text_idx_map_[unit_team_id];
+            text_idx = (unit->is_dead()) ? 3 : team_id_text_idx_map_[unit_spr.second.handle.team_id];
         }
-        unit_spr.second.setTextureRect(sf::IntRect(textW*text_idx,0,textW,textW));
+        sprite.setTextureRect(sf::IntRect(textW*text_idx,0,textW,textW));
     }
     return;
 }
@@ -42,11 +42,22 @@ public:
     void set_tile_map(std::shared_ptr<Tile_Map>& tile_map);
 
 private:
+    struct Unit_Sprite {
+        UnitHandle handle; //The unit of the sprite, a handle so removed units don't leave a dangling pointer behind.
+        sf::Sprite sprite;
+    };
+
     std::shared_ptr<Tile_Map> tile_map_;
-    std::unordered_map<Unit*,sf::Sprite> unit_sprite_map_; //Contains sprites for every unit found in map.
+    std::unordered_map<int,Unit_Sprite> unit_sprite_map_; //Contains sprites for every unit found in map, keyed by unit id.
     std::unordered_map<int,int> team_id_text_idx_map_; //Assigns a textures id to a certain team id.
     sf::Texture unit_text; //Contains all textures for units.
 
+    /**
+     * @brief Creates the sprites of units that don't have one yet (all of them on load, reinforcements later)
+     * and removes the sprites of units that have been removed from their team.
+     */
+    void update_unit_sprites();
+
     /**
      * @brief Makes sure that textures and postions for every unit are up to date.
      */
@@ -57,8 +68,8 @@ private:
      * @brief Used to draw all drawables on a sf::RenderWindow.
      */
     void draw(sf::RenderTarget& target, sf::RenderStates states) const override {
-        for (auto spr : unit_sprite_map_) {
-            target.draw(spr.second,states);
+        for (auto& spr : unit_sprite_map_) {
+            target.draw(spr.second.sprite,states);
         }
         return;
     }
@@ -15,9 +15,15 @@ bool Tile_Map::is_tile_drawn(size_t x, size_t y) const {
 }
 
 bool Tile_Map::is_tile_drawn(const coordinates<size_t>& coords) const {
-    const std::vector<coordinates<size_t>>& visible_coords = game_->get_visible_tiles();
-    auto coord_it = std::find(visible_coords.begin(), visible_coords.end(), coords);
-    return ((!fog_of_war) || (coord_it != visible_coords.end()));
+    return (!fog_of_war) || game_->is_visible(coords);
+}
+
+size_t Tile_Map::visibility_version() const {
+    return game_->visibility_version();
+}
+
+const BitGrid& Tile_Map::visibility_changes() const {
+    return game_->visibility_changes();
 }
 
 void Tile_Map::move(float x, float y) {
@@ -17,11 +17,21 @@ public:
     Tile_Map(std::shared_ptr<Game>& game, std::pair<float, float> x0y0, int tileDim);
 
     /**
-     * @brief Checks of a tile in certain coords is show or hidden due to fog of war. Uses visible_coords from game.
+     * @brief Checks of a tile in certain coords is show or hidden due to fog of war. Uses the visibility bits from game.
      */
     bool is_tile_drawn(size_t x, size_t y) const;
     bool is_tile_drawn(const coordinates<size_t>& coords) const;
 
+    /**
+     * @brief Changes every time the visible tiles of the game change.
+     */
+    size_t visibility_version() const;
+
+    /**
+     * @brief The tiles that turned visible or hidden with the last change of visibility_version.
+     */
+    const BitGrid& visibility_changes() const;
+
     bool fog_of_war = true; //Can be used to toggle fog of war. Only for developing.
 
     /**
@@ -0,0 +1,537 @@
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include "ai_test.hpp"
+#include "game.hpp"
+#include "enemy_ai.hpp"
+#include "action.hpp"
+#include "item.hpp"
+#include "thread_pool.hpp"
+#include "influence_map.hpp"
+#include "mcts_ai.hpp"
+
+/*
+ * Test of the parallel turn planning of EnemyAI. Two copies of the same game are planned with a different
+ * amount of jobs and the same seed, and the queued actions and the locations of the units have to be the same.
+ * No two units can end up on the same tile. Units far from their patrol ranges search their way back on the threads
+ * the same way as one at a time, also after the terrain changed under the hierarchical pathfinder. Units added to the team
+ * during the game patrol around where they were added, with the serial and the parallel planning. Also prints how long
+ * planning the turn of a big team takes with the serial planning and with the parallel planning on 1-8 jobs.
+ *
+ * The influence map kept up to date while units move, die and get new items has to be the same as one built
+ * from nothing, and the units a unit sees found from the occupancy layer the same as the units on the tiles it sees.
+ *
+ * MctsAI has to plan the same turn with the same seed when the simulations are limited, take the kill when one of the enemies
+ * it can shoot is almost dead, and stay within its time budget, also with a big team where most units are left to the rules.
+ * Prints how many simulations it runs in a turn.
+ */
+
+// A game with two teams of <team_size> units on a map with random walls, the units of the second team are controlled by the AI
+static std::unique_ptr<Game> make_game(size_t side, size_t team_size, uint32_t seed) {
+    auto game = std::make_unique<Game>(side, side);
+    Map& map = game->get_map();
+    std::mt19937 rng(seed);
+    for (size_t y = 0; y < side; y++) {
+        for (size_t x = 0; x < side; x++) {
+            if (rng() % 10 == 0) map.update_terrain('#', y, x);
+        }
+    }
+
+    for (int t = 0; t < 2; t++) {
+        Team team;
+        for (size_t i = 0; i < team_size; i++) {
+            Unit unit("unit");
+            unit.add_item(std::make_shared<Weapon>("gun", 80, 20, 0));
+            team.add_unit(unit);
+        }
+        game->add_team(team);
+    }
+    // The teams start on the opposite sides of the map
+    for (int t = 0; t < 2; t++) {
+        for (Unit& unit : game->get_teams()[t].get_units()) {
+            coordinates<size_t> location;
+            do {
+                location = {rng() % side, (t == 0 ? 0 : side / 2) + rng() % (side / 2)};
+            } while (!map.can_move_to_coords(location.y, location.x));
+            map.add_unit(location, &unit);
+        }
+    }
+    return game;
+}
+
+// The queued actions of the AI team as (unit index, movement, target), and the locations of all the units
+static std::vector<size_t> turn_result(Game& game) {
+    std::vector<size_t> result;
+    Team& ai_team = game.get_teams()[1];
+    while (std::shared_ptr<Action> action = ai_team.dequeue_action()) {
+        result.push_back(action->get_unit().get_id() - ai_team.get_units().front().get_id());
+        result.push_back(action->is_movement());
+        result.push_back(action->target().x);
+        result.push_back(action->target().y);
+    }
+    for (Unit* unit : game.get_units()) {
+        coordinates<size_t> location = game.get_map().get_unit_location(unit);
+        result.push_back(location.x);
+        result.push_back(location.y);
+    }
+    return result;
+}
+
+static bool check_deterministic(uint32_t seed) {
+    std::vector<size_t> first_result;
+    bool ok = true;
+    for (size_t jobs : {1, 2, 4}) {
+        std::unique_ptr<Game> game = make_game(40, 40, seed);
+        EnemyAI ai(*game, game->get_teams()[1]);
+        ai.set_planning_seed(seed);
+        ThreadPool pool(jobs);
+        ai.generate_whole_teams_turns_parallel(pool);
+
+        // No two units on the same tile: every unit is found where the map says it is
+        for (Unit* unit : game->get_units()) {
+            ok &= game->get_map().get_unit(game->get_map().get_unit_location(unit)) == unit;
+        }
+
+        std::vector<size_t> result = turn_result(*game);
+        if (first_result.empty()) first_result = result;
+        ok &= result == first_result;
+    }
+    return ok;
+}
+
+// Units taken far from their patrol ranges search the way back on the threads, on a map with hierarchical pathfinding whose
+// clusters changed after it was built. The turns are the same with any amount of jobs and the same as searching one unit at a time
+static bool check_return_to_patrol_range() {
+    const size_t side = 96;
+    std::unique_ptr<Game> game = make_game(side, 30, 13);
+    Map& map = game->get_map();
+    map.enable_hierarchical_pathfinding();
+    // No enemies, so every unit patrols
+    for (Unit& unit : game->get_teams()[0].get_units()) unit.change_hp_by(-unit_consts.max_hp);
+    Team& ai_team = game->get_teams()[1];
+    EnemyAI ai(*game, ai_team);
+
+    // Every other unit is taken to the other half of the map, away from where its patrol range was set
+    std::mt19937 rng(13);
+    std::vector<Unit*> far_units;
+    std::vector<coordinates<size_t>> centers;
+    for (size_t i = 0; i < ai_team.get_units().size(); i += 2) {
+        Unit* unit = &ai_team.get_units()[i];
+        coordinates<size_t> location;
+        do {
+            location = {rng() % side, rng() % (side / 2)};
+        } while (!map.can_move_to_coords(location.y, location.x));
+        centers.push_back(map.get_unit_location(unit));
+        map.move_unit(centers.back(), location);
+        far_units.push_back(unit);
+    }
+    for (int i = 0; i < 20; i++) {
+        coordinates<size_t> wall(rng() % side, rng() % side);
+        if (map.can_move_to_coords(wall.y, wall.x)) map.update_terrain('#', wall.y, wall.x);
+    }
+
+    // The locations of the units after the turn planned with each amount of jobs, the turn is undone after each
+    bool ok = true;
+    std::vector<coordinates<size_t>> first_result;
+    for (size_t jobs : {1, 2, 4}) {
+        ai.set_planning_seed(13);
+        ThreadPool pool(jobs);
+        ai.generate_whole_teams_turns_parallel(pool);
+        std::vector<coordinates<size_t>> result;
+        for (Unit* unit : far_units) result.push_back(map.get_unit_location(unit));
+        for (Unit* unit : game->get_units()) result.push_back(map.get_unit_location(unit));
+        if (first_result.empty()) first_result = result;
+        ok &= result == first_result;
+        while (game->undo_action(ai_team.get_id())) {}
+    }
+
+    // The same searches one unit at a time, a unit whose tile was taken by a unit before it stays
+    size_t moved = 0;
+    for (size_t i = 0; i < far_units.size(); i++) {
+        const coordinates<size_t> location = map.get_unit_location(far_units[i]);
+        ok &= first_result[i] == map.fastest_movement_to_target(location, centers[i], unit_consts.move_range) || first_result[i] == location;
+        moved += first_result[i] != location;
+    }
+    return ok && moved > far_units.size() / 2;
+}
+
+// Units added to the AI team during the game patrol around where they were added, planned one after another and in parallel,
+// and planning goes on after a unit is removed from the team
+static bool check_reinforcements() {
+    bool ok = true;
+    for (size_t jobs : {1, 2}) {
+        const size_t side = 48;
+        std::unique_ptr<Game> game = make_game(side, 10, 17);
+        // No enemies, so every unit patrols
+        for (Unit& unit : game->get_teams()[0].get_units()) unit.change_hp_by(-unit_consts.max_hp);
+        Team& ai_team = game->get_teams()[1];
+        EnemyAI ai(*game, ai_team);
+        ai.set_planning_jobs(jobs);
+
+        std::mt19937 rng(17);
+        std::vector<UnitHandle> reinforcements;
+        std::vector<coordinates<size_t>> added_at;
+        while (reinforcements.size() < 5) {
+            const coordinates<size_t> location(rng() % side, rng() % side);
+            const UnitHandle handle = game->add_unit(ai_team.get_id(), Unit("reinforcement"), location);
+            if (!handle.valid()) continue;
+            reinforcements.push_back(handle);
+            added_at.push_back(location);
+        }
+        ok &= game->remove_unit(ai_team.get_units().front().get_handle());
+        ai.generate_whole_teams_turns();
+
+        size_t movements = 0;
+        while (std::shared_ptr<Action> action = ai_team.dequeue_action()) {
+            movements += action->is_movement();
+        }
+        ok &= movements == ai_team.get_alive_units().size();
+
+        // The patrol range is the square of 6 tiles around where the unit was added
+        for (size_t i = 0; i < reinforcements.size(); i++) {
+            const coordinates<size_t> location = game->get_map().get_unit_location(game->get_unit(reinforcements[i]));
+            ok &= location.x + 2 >= added_at[i].x && location.x <= added_at[i].x + 3;
+            ok &= location.y + 2 >= added_at[i].y && location.y <= added_at[i].y + 3;
+        }
+    }
+    return ok;
+}
+
+// The threat and support of every tile of two influence maps are the same
+static bool same_influence(const InfluenceMap& a, const InfluenceMap& b, size_t side) {
+    for (size_t y = 0; y < side; y++) {
+        for (size_t x = 0; x < side; x++) {
+            if (a.threat(y, x) != b.threat(y, x) || a.support(y, x) != b.support(y, x)) return false;
+        }
+    }
+    return true;
+}
+
+static bool check_influence_map() {
+    const size_t side = 48;
+    std::unique_ptr<Game> game = make_game(side, 40, 3);
+    Map& map = game->get_map();
+    std::mt19937 rng(11);
+    // Some healers on the AI team so there's support too
+    for (size_t i = 0; i < 10; i++) {
+        game->get_teams()[1].get_units()[i].add_item(std::make_shared<HealingItem>("medkit", 30));
+    }
+
+    bool ok = true;
+    InfluenceMap incremental;
+    for (int round = 0; round < 30; round++) {
+        incremental.update(map, game->get_teams(), game->get_teams()[1].get_id());
+        InfluenceMap fresh;
+        fresh.update(map, game->get_teams(), game->get_teams()[1].get_id());
+        ok &= same_influence(incremental, fresh, side);
+
+        // Move some units, kill one and give one a better weapon
+        std::vector<Unit*> units = game->get_units();
+        for (int i = 0; i < 10; i++) {
+            Unit* unit = units[rng() % units.size()];
+            coordinates<size_t> from = map.get_unit_location(unit);
+            coordinates<size_t> to(std::min(side - 1, from.x + rng() % 3), std::min(side - 1, from.y + rng() % 3));
+            if (map.can_move_to_coords(to.y, to.x)) map.move_unit(from, to);
+        }
+        units[rng() % units.size()]->change_hp_by(-unit_consts.max_hp);
+        units[rng() % units.size()]->add_item(std::make_shared<Weapon>("cannon", 50, 60, 10));
+    }
+
+    // Threat is the expected damage of the best weapon, so right next to an enemy with an 80% gun of 20 damage it's at least 16
+    InfluenceMap influence;
+    influence.update(map, game->get_teams(), game->get_teams()[1].get_id());
+    for (Unit* unit : game->get_teams()[0].get_alive_units()) {
+        coordinates<size_t> location = map.get_unit_location(unit);
+        ok &= influence.threat(location.y, location.x) >= 16;
+        ok &= influence.is_enemy(unit);
+    }
+    for (Unit* unit : game->get_teams()[1].get_alive_units()) {
+        ok &= influence.knows(unit) && !influence.is_enemy(unit);
+    }
+    return ok;
+}
+
+static bool check_units_in_sight() {
+    const size_t side = 48;
+    std::unique_ptr<Game> game = make_game(side, 60, 5);
+    Map& map = game->get_map();
+    bool ok = true;
+    for (size_t y = 0; y < side; y += 3) {
+        for (size_t x = 0; x < side; x += 3) {
+            for (uint32_t range : {1u, 5u, 9u}) {
+                std::vector<coordinates<size_t>> expected;
+                for (const coordinates<size_t>& coords : map.tiles_unit_sees({x, y}, range)) {
+                    if (map.get_unit(coords) != nullptr) expected.push_back(coords);
+                }
+                ok &= map.units_in_sight<LosPolicy::SeeThrough>({x, y}, range) == expected;
+            }
+        }
+    }
+    return ok;
+}
+
+// How long looking up the enemies every unit of the AI team sees takes, by going through its visible tiles and the teams of the
+// units on them and by checking the occupied tiles in range against the influence map
+static void benchmark_enemy_lookup() {
+    const size_t side = 128;
+    std::unique_ptr<Game> game = make_game(side, 200, 9);
+    Map& map = game->get_map();
+    Team& ai_team = game->get_teams()[1];
+    InfluenceMap influence;
+    influence.update(map, game->get_teams(), ai_team.get_id());
+
+    size_t scan_found = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (Unit* unit : ai_team.get_alive_units()) {
+        for (const coordinates<size_t>& coords : map.tiles_unit_sees(map.get_unit_location(unit), unit_consts.visual_range)) {
+            Unit* seen = map.get_unit(coords);
+            if (seen != nullptr && game->get_unit_team_id(seen->get_id()) != ai_team.get_id()) scan_found++;
+        }
+    }
+    auto scan_time = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+    size_t influence_found = 0;
+    start = std::chrono::steady_clock::now();
+    for (Unit* unit : ai_team.get_alive_units()) {
+        for (const coordinates<size_t>& coords : map.units_in_sight<LosPolicy::SeeThrough>(map.get_unit_location(unit), unit_consts.visual_range)) {
+            if (influence.is_enemy(map.get_unit(coords))) influence_found++;
+        }
+    }
+    auto influence_time = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "Enemies seen by 200 units: " << scan_time << " us from the visible tiles, " << influence_time << " us from the occupied tiles"
+              << (scan_found == influence_found ? "" : " (DIFFERENT RESULTS)") << std::endl;
+
+    // Updating the influence map after one unit moved compared to building it from nothing
+    Unit* mover = ai_team.get_alive_units().front();
+    coordinates<size_t> location = map.get_unit_location(mover);
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 100; i++) {
+        coordinates<size_t> next(location.x, location.y + (i % 2 == 0 ? 1 : -1));
+        if (map.can_move_to_coords(next.y, next.x)) map.move_unit(location, next);
+        location = map.get_unit_location(mover);
+        influence.update(map, game->get_teams(), ai_team.get_id());
+    }
+    auto incremental_time = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / 100;
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 10; i++) {
+        InfluenceMap fresh;
+        fresh.update(map, game->get_teams(), ai_team.get_id());
+    }
+    auto fresh_time = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / 10;
+    std::cout << "Influence map of 400 units: " << incremental_time << " us to update after one unit moved, " << fresh_time << " us from nothing" << std::endl;
+}
+
+// A game on an open map where every unit has a gun, the AI team <ai_units> units fighting <enemy_units> enemies close by
+static std::unique_ptr<Game> make_battle(size_t ai_units, size_t enemy_units, uint32_t seed) {
+    const size_t side = 24;
+    auto game = std::make_unique<Game>(side, side);
+    std::mt19937 rng(seed);
+    for (size_t count : {enemy_units, ai_units}) {
+        Team team;
+        for (size_t i = 0; i < count; i++) {
+            Unit unit("unit");
+            unit.add_item(std::make_shared<Weapon>("gun", 70, 25, 5));
+            team.add_unit(unit);
+        }
+        game->add_team(team);
+    }
+    for (int t = 0; t < 2; t++) {
+        for (Unit& unit : game->get_teams()[t].get_units()) {
+            coordinates<size_t> location;
+            do {
+                location = {(t == 0 ? 6 : 12) + rng() % 6, 4 + rng() % 16};
+            } while (!game->get_map().can_move_to_coords(location.y, location.x));
+            game->get_map().add_unit(location, &unit);
+        }
+    }
+    return game;
+}
+
+static bool check_mcts_deterministic() {
+    std::vector<size_t> first_result;
+    bool ok = true;
+    for (int run = 0; run < 2; run++) {
+        std::unique_ptr<Game> game = make_battle(6, 6, 21);
+        MctsAI ai(*game, game->get_teams()[1]);
+        ai.set_planning_jobs(2);
+        ai.set_planning_seed(5);
+        ai.set_iteration_limit(300);
+        ai.set_turn_time_budget(std::chrono::milliseconds(60000));
+        ai.generate_whole_teams_turns();
+
+        for (Unit* unit : game->get_units()) {
+            ok &= game->get_map().get_unit(game->get_map().get_unit_location(unit)) == unit;
+        }
+        std::vector<size_t> result = turn_result(*game);
+        if (first_result.empty()) first_result = result;
+        ok &= result == first_result && !result.empty();
+    }
+    return ok;
+}
+
+static bool check_mcts_takes_kill() {
+    auto game = std::make_unique<Game>(16, 16);
+    Team enemies;
+    enemies.add_unit(Unit("healthy"));
+    enemies.add_unit(Unit("almost dead"));
+    game->add_team(enemies);
+    Team ai_team;
+    Unit shooter("shooter");
+    shooter.add_item(std::make_shared<Weapon>("rifle", 100, 30, 0));
+    ai_team.add_unit(shooter);
+    game->add_team(ai_team);
+
+    Map& map = game->get_map();
+    Unit& healthy = game->get_teams()[0].get_units()[0];
+    Unit& almost_dead = game->get_teams()[0].get_units()[1];
+    almost_dead.change_hp_by(-80);
+    map.add_unit(coordinates<size_t>(8, 6), &healthy);
+    map.add_unit(coordinates<size_t>(8, 10), &almost_dead);
+    map.add_unit(coordinates<size_t>(8, 8), &game->get_teams()[1].get_units()[0]);
+
+    MctsAI ai(*game, game->get_teams()[1]);
+    ai.set_planning_jobs(1);
+    ai.set_iteration_limit(500);
+    ai.generate_whole_teams_turns();
+
+    // The movement is executed right away, the attack is queued after it
+    bool attacked = false;
+    while (std::shared_ptr<Action> action = game->get_teams()[1].dequeue_action()) {
+        if (!action->is_movement()) attacked = action->target() == map.get_unit_location(&almost_dead);
+    }
+    return attacked;
+}
+
+// With no time left the search stops right away, and every unit still gets the option that scores best without search
+static bool check_mcts_hard_budget() {
+    std::unique_ptr<Game> game = make_battle(12, 12, 8);
+    MctsAI ai(*game, game->get_teams()[1]);
+    ai.set_planning_jobs(1);
+    ai.set_turn_time_budget(std::chrono::milliseconds(0));
+    ai.generate_whole_teams_turns();
+
+    size_t movements = 0;
+    while (std::shared_ptr<Action> action = game->get_teams()[1].dequeue_action()) {
+        movements += action->is_movement();
+    }
+    if (ai.last_turn_simulations() != 0 || movements != 12) return false;
+
+    // A big team where most of the units are too far to search and are moved by the rules, the turn has to fit in the
+    // budget with them and the committed moves, give or take a tenth
+    const auto budget = std::chrono::milliseconds(100);
+    std::unique_ptr<Game> big_game = make_game(128, 400, 8);
+    // The AI team is the active one, so every committed move updates what it sees
+    big_game->init_game();
+    big_game->next_turn();
+    MctsAI big_ai(*big_game, big_game->get_teams()[1]);
+    big_ai.set_planning_jobs(1);
+    big_ai.set_turn_time_budget(budget);
+    auto start = std::chrono::steady_clock::now();
+    big_ai.generate_whole_teams_turns();
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    movements = 0;
+    while (std::shared_ptr<Action> action = big_game->get_teams()[1].dequeue_action()) {
+        movements += action->is_movement();
+    }
+    return movements == 400 && elapsed <= budget + budget / 10;
+}
+
+// How long a turn of MctsAI takes with a time budget and how many simulations it runs in it
+static void benchmark_mcts() {
+    for (size_t jobs : {1, 4}) {
+        std::unique_ptr<Game> game = make_battle(12, 12, 8);
+        MctsAI ai(*game, game->get_teams()[1]);
+        ai.set_planning_jobs(jobs);
+        ai.set_turn_time_budget(std::chrono::milliseconds(200));
+        auto start = std::chrono::steady_clock::now();
+        ai.generate_whole_teams_turns();
+        auto time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "MCTS turn of 12 units with a 200 ms budget on " << jobs << " jobs: " << time << " ms, "
+                  << ai.last_turn_simulations() << " simulations" << std::endl;
+    }
+}
+
+// Battles of 6 units a side where the second team is played by MctsAI or EnemyAI and the first by EnemyAI, returns the wins of the
+// second team: the battles it has more HP left than the first team after 10 turns each
+static int play_battles(bool monte_carlo, int battles) {
+    int wins = 0;
+    for (int battle = 0; battle < battles; battle++) {
+        std::unique_ptr<Game> game = make_battle(6, 6, 100 + battle);
+        Team& opponents = game->get_teams()[0];
+        Team& team = game->get_teams()[1];
+        EnemyAI opponent_ai(*game, opponents);
+        std::unique_ptr<AIController> ai;
+        if (monte_carlo) {
+            auto mcts = std::make_unique<MctsAI>(*game, team);
+            mcts->set_planning_jobs(1);
+            mcts->set_turn_time_budget(std::chrono::milliseconds(20));
+            ai = std::move(mcts);
+        } else {
+            ai = std::make_unique<EnemyAI>(*game, team);
+        }
+
+        // Every other battle the opponents start
+        for (int turn = battle % 2; turn < 20 + battle % 2; turn++) {
+            if (turn % 2 == 0) {
+                ai->generate_whole_teams_turns();
+                game->end_team_turns(team.get_id());
+            } else {
+                opponent_ai.generate_whole_teams_turns();
+                game->end_team_turns(opponents.get_id());
+            }
+        }
+
+        int hp = 0;
+        for (Unit& unit : team.get_units()) hp += std::max(0, unit.get_hp());
+        for (Unit& unit : opponents.get_units()) hp -= std::max(0, unit.get_hp());
+        wins += hp > 0;
+    }
+    return wins;
+}
+
+void ai_test() {
+    bool ok = true;
+    for (uint32_t seed = 1; seed <= 5; seed++) {
+        ok &= check_deterministic(seed);
+    }
+    std::cout << (ok ? "Parallel planning gives the same turns with any amount of jobs" : "Parallel planning DOESN'T give the same turns with any amount of jobs") << std::endl;
+    std::cout << (check_return_to_patrol_range() ? "Units search their way back to their patrol ranges in parallel" : "Units DON'T search their way back to their patrol ranges in parallel") << std::endl;
+    std::cout << (check_reinforcements() ? "Units added to the AI team during the game patrol where they were added" : "Units added to the AI team during the game DON'T patrol where they were added") << std::endl;
+
+    std::cout << (check_influence_map() ? "Incremental influence map is the same as a new one" : "Incremental influence map is NOT the same as a new one") << std::endl;
+    std::cout << (check_units_in_sight() ? "Units in sight are the same as the units on the visible tiles" : "Units in sight are NOT the same as the units on the visible tiles") << std::endl;
+    benchmark_enemy_lookup();
+
+    std::cout << (check_mcts_deterministic() ? "MCTS plans the same turn with the same seed" : "MCTS DOESN'T plan the same turn with the same seed") << std::endl;
+    std::cout << (check_mcts_takes_kill() ? "MCTS shoots the enemy it can kill" : "MCTS DOESN'T shoot the enemy it can kill") << std::endl;
+    std::cout << (check_mcts_hard_budget() ? "MCTS stops at the end of its time budget" : "MCTS DOESN'T stop at the end of its time budget") << std::endl;
+    benchmark_mcts();
+    std::cout << "Wins of 8 battles against EnemyAI: " << play_battles(false, 8) << " with EnemyAI, " << play_battles(true, 8) << " with MctsAI" << std::endl;
+
+    const size_t side = 128;
+    const size_t team_size = 200;
+    {
+        std::unique_ptr<Game> game = make_game(side, team_size, 7);
+        EnemyAI ai(*game, game->get_teams()[1]);
+        auto start = std::chrono::steady_clock::now();
+        ai.generate_whole_teams_turns();
+        auto serial_time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Turn of " << team_size << " AI units: " << serial_time << " ms planned one after another" << std::endl;
+    }
+    for (size_t jobs : {1, 2, 4, 8}) {
+        std::unique_ptr<Game> game = make_game(side, team_size, 7);
+        EnemyAI ai(*game, game->get_teams()[1]);
+        ThreadPool pool(jobs);
+        auto start = std::chrono::steady_clock::now();
+        ai.generate_whole_teams_turns_parallel(pool);
+        auto parallel_time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Turn of " << team_size << " AI units: " << parallel_time << " ms planned in parallel with " << jobs << " jobs" << std::endl;
+    }
+}
@@ -0,0 +1,6 @@
+#ifndef AI_TEST_HPP
+#define AI_TEST_HPP
+
+void ai_test();
+
+#endif //AI_TEST_HPP
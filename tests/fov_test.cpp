@@ -0,0 +1,699 @@
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <random>
+#include <chrono>
+#include <set>
+#include <functional>
+
+#include "fov_test.hpp"
+#include "map.hpp"
+#include "unit.hpp"
+#include "team_visibility.hpp"
+#include "thread_pool.hpp"
+#include "game.hpp"
+#include "team.hpp"
+
+/*
+ * Test of the shadowcasting field of view. Checks that the view is symmetric (if A sees B, B sees A)
+ * and that nothing blocks the view on an empty map, then compares the time of a tiles_unit_sees call
+ * with the Bresenham ray fan it replaced for ranges 5-30. Also compares the field of view with a LosPolicy
+ * to the same shadowcasting through a std::function predicate, like line_of_sight_check used to take.
+ * The point to point line of sight check is compared to the full field of view for every pair of tiles in range.
+ * The incrementally updated TeamVisibility is compared to calculating the views of every unit again.
+ * The cached line of sight results are checked against an uncached field of view while the terrain changes.
+ * The precomputed disc tables are checked against the radius test they replaced, also past the ranges they cover.
+ * The bit layer kernels are checked bit by bit and timed on 1024x1024 grids against combining coordinate lists.
+ * The area of effect units are compared to filtering the area of effect tiles for units.
+ * The views of a team calculated on a thread pool are compared to calculating them on one thread, and timed with 1-8 jobs.
+ */
+
+static Map make_map(size_t side, uint32_t seed) {
+    Map map(side, side);
+    std::mt19937 rng(seed);
+    for (size_t y = 0; y < side; y++) {
+        for (size_t x = 0; x < side; x++) {
+            if (rng() % 8 == 0) map.update_terrain('#', y, x);
+        }
+    }
+    return map;
+}
+
+// The previous implementation of Map::line_of_sight_check, Bresenham rays to the tiles of two Andres circles
+static std::vector<coordinates<size_t>> ray_fan(Map& map, const coordinates<size_t>& location, uint32_t range, const std::function<bool(int64_t y, int64_t x)>& predicate) {
+    std::vector<coordinates<size_t>> max_range_coords = map.max_visible_locations(location, range);
+    std::vector<coordinates<size_t>> max_range_coords1 = map.max_visible_locations(location, range - 1);
+    max_range_coords.insert(max_range_coords.end(), max_range_coords1.begin(), max_range_coords1.end());
+
+    std::set<coordinates<size_t>> visible_coords = { {location.x, location.y} };
+    const int64_t height = map.height();
+    const int64_t width = map.width();
+
+    for (const coordinates<size_t>& a_side : max_range_coords) {
+        int64_t x0 = location.x;
+        int64_t y0 = location.y;
+        int64_t x1 = a_side.x;
+        int64_t y1 = a_side.y;
+        int64_t dx = std::abs(x1 - x0);
+        int64_t sx = (x0 < x1) ? 1 : -1;
+        int64_t dy = -std::abs(y1 - y0);
+        int64_t sy = (y0 < y1) ? 1 : -1;
+        int64_t error = dx + dy;
+
+        while (!(x0 == x1 && y0 == y1)) {
+            int64_t e2 = 2 * error;
+            if (e2 >= dy) { error += dy; x0 += sx; }
+            if (e2 <= dx) { error += dx; y0 += sy; }
+
+            if (y0 < 0 || y0 >= height || x0 < 0 || x0 >= width) break;
+            if (!predicate(y0, x0)) {
+                visible_coords.emplace(x0, y0);
+                break;
+            }
+            if (!predicate(Helper::clamp(y0 - sy, 0, height - 1), x0) && !predicate(y0, Helper::clamp(x0 - sx, 0, width - 1))) break;
+            visible_coords.emplace(x0, y0);
+        }
+    }
+
+    return {visible_coords.begin(), visible_coords.end()};
+}
+
+static bool check_symmetry(size_t side, uint32_t seed) {
+    Map map = make_map(side, seed);
+    std::mt19937 rng(seed);
+    bool ok = true;
+
+    for (int i = 0; i < 50; i++) {
+        coordinates<size_t> a(rng() % side, rng() % side);
+        if (!map.can_see_through(a.y, a.x)) continue;
+
+        const uint32_t range = 5 + rng() % 10;
+        for (const auto& b : map.tiles_unit_sees(a, range)) {
+            if (!map.can_see_through(b.y, b.x)) continue; // Walls are seen but don't look back
+            std::vector<coordinates<size_t>> seen_from_b = map.tiles_unit_sees(b, range);
+            if (!std::binary_search(seen_from_b.begin(), seen_from_b.end(), a)) {
+                std::cout << "(" << a.x << ", " << a.y << ") sees (" << b.x << ", " << b.y << ") but not the other way around" << std::endl;
+                ok = false;
+            }
+        }
+    }
+    return ok;
+}
+
+static bool check_range_tables() {
+    bool ok = true;
+    for (int64_t range = 0; range <= RangeTables::max_range + 20; range++) {
+        for (int64_t dy = -range - 1; dy <= range + 1; dy++) {
+            int64_t half_width = -1;
+            for (int64_t dx = 0; dx * dx + dy * dy <= range * range + range; dx++) half_width = dx;
+            ok &= RangeTables::disc_half_width(range, dy) == half_width;
+        }
+    }
+    return ok;
+}
+
+static BitGrid random_grid(size_t height, size_t width, uint32_t seed) {
+    BitGrid grid(height, width);
+    std::mt19937 rng(seed);
+    for (size_t y = 0; y < height; y++) {
+        for (size_t x = 0; x < width; x++) {
+            if (rng() % 3 == 0) grid.set(y, x);
+        }
+    }
+    return grid;
+}
+
+// The kernels have to give the same bits as combining the grids one bit at a time, also with widths that don't fill whole vectors
+static bool check_bit_kernels() {
+    bool ok = true;
+    for (size_t width : {1, 63, 64, 130, 200, 1000}) {
+        BitGrid a = random_grid(7, width, width);
+        BitGrid b = random_grid(7, width, width + 1);
+        BitGrid united(7, width), intersected(7, width), difference(7, width), symmetric(7, width);
+        BitGrid::unite(a, b, united);
+        BitGrid::intersect(a, b, intersected);
+        BitGrid::and_not(a, b, difference);
+        BitGrid::symmetric_difference(a, b, symmetric);
+
+        for (size_t y = 0; y < 7; y++) {
+            for (size_t x = 0; x < width; x++) {
+                ok &= united.test(y, x) == (a.test(y, x) || b.test(y, x));
+                ok &= intersected.test(y, x) == (a.test(y, x) && b.test(y, x));
+                ok &= difference.test(y, x) == (a.test(y, x) && !b.test(y, x));
+                ok &= symmetric.test(y, x) == (a.test(y, x) != b.test(y, x));
+            }
+        }
+        ok &= united.count() <= 7 * width && symmetric.any() && !BitGrid(7, width).any();
+    }
+    return ok;
+}
+
+// What the active team of the game sees as bits
+static BitGrid visible_grid(const Game& game, const Map& map) {
+    BitGrid visible(map.height(), map.width());
+    for (size_t y = 0; y < map.height(); y++) {
+        for (size_t x = 0; x < map.width(); x++) {
+            if (game.is_visible({x, y})) visible.set(y, x);
+        }
+    }
+    return visible;
+}
+
+// A renderer that only applies visibility_changes when the visibility changed once since it last drew has to end up with
+// the tiles the team sees, also when units move inside of what the team already sees between the draws
+static bool check_visibility_changes() {
+    Game game(24, 4);
+    Team team;
+    const int team_id = team.get_id();
+    game.add_team(team);
+    game.init_game();
+    const Map& map = game.get_map();
+
+    BitGrid drawn(map.height(), map.width());
+    size_t drawn_version = game.visibility_version();
+    bool ok = true;
+    auto draw = [&]() {
+        if (game.visibility_version() == drawn_version + 1) {
+            BitGrid::symmetric_difference(drawn, game.visibility_changes(), drawn);
+        } else if (game.visibility_version() != drawn_version) {
+            drawn = visible_grid(game, map);
+        }
+        drawn_version = game.visibility_version();
+        BitGrid difference(map.height(), map.width());
+        BitGrid::symmetric_difference(drawn, visible_grid(game, map), difference);
+        ok &= !difference.any();
+    };
+
+    game.add_unit(team_id, Unit("a"), {2, 1});
+    draw();
+    ok &= drawn.any();
+    // The view of a unit on the row below is the same on a map of 4 rows, so the second change doesn't change any tiles
+    const UnitHandle far = game.add_unit(team_id, Unit("far"), {14, 1});
+    const size_t version = game.visibility_version();
+    game.add_unit(team_id, Unit("b"), {2, 2});
+    ok &= game.visibility_version() == version;
+    draw();
+    game.remove_unit(far);
+    draw();
+    return ok;
+}
+
+static void benchmark_bit_kernels() {
+    const size_t side = 1024;
+    const int repeats = 100;
+    BitGrid a = random_grid(side, side, 1);
+    BitGrid b = random_grid(side, side, 2);
+    BitGrid out(side, side);
+
+    auto time_kernel = [&](void (*kernel)(const BitGrid&, const BitGrid&, BitGrid&)) {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < repeats; i++) {
+            kernel(a, b, out);
+        }
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / repeats;
+    };
+    const double unite_time = time_kernel(BitGrid::unite);
+    const double intersect_time = time_kernel(BitGrid::intersect);
+    const double difference_time = time_kernel(BitGrid::and_not);
+    const double symmetric_time = time_kernel(BitGrid::symmetric_difference);
+
+    // The union as it was done with coordinate lists: concatenated, sorted and the duplicates erased
+    std::vector<coordinates<size_t>> a_coords, b_coords;
+    for (size_t y = 0; y < side; y++) {
+        for (size_t x = 0; x < side; x++) {
+            if (a.test(y, x)) a_coords.emplace_back(x, y);
+            if (b.test(y, x)) b_coords.emplace_back(x, y);
+        }
+    }
+    auto start = std::chrono::steady_clock::now();
+    std::vector<coordinates<size_t>> united = a_coords;
+    united.insert(united.end(), b_coords.begin(), b_coords.end());
+    std::sort(united.begin(), united.end());
+    united.erase(std::unique(united.begin(), united.end()), united.end());
+    const double list_time = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+    BitGrid::unite(a, b, out);
+    std::cout << side << "x" << side << " bit layers (" << BitKernels::instruction_set() << "): union " << unite_time
+              << " us, intersection " << intersect_time << " us, difference " << difference_time << " us, symmetric difference "
+              << symmetric_time << " us. Union of coordinate lists " << list_time << " us"
+              << (united.size() == out.count() ? "" : " (DIFFERENT RESULTS)") << std::endl;
+}
+
+static bool check_open_map() {
+    Map map(100, 100);
+    bool ok = true;
+    for (uint32_t range = 1; range <= 30; range++) {
+        std::vector<coordinates<size_t>> visible = map.tiles_unit_sees({50, 50}, range);
+        size_t disc = 0;
+        for (int64_t dy = -int64_t(range); dy <= int64_t(range); dy++) {
+            for (int64_t dx = -int64_t(range); dx <= int64_t(range); dx++) {
+                disc += dx * dx + dy * dy <= range * range + range;
+            }
+        }
+        ok &= visible.size() == disc;
+    }
+    return ok;
+}
+
+// Times field_of_view with the SeeThrough policy against the same field of view with a type-erased predicate
+static void benchmark_policy(Map& map, const std::vector<coordinates<size_t>>& origins) {
+    const std::function<bool(int64_t y, int64_t x)> predicate = [&map](int64_t y, int64_t x) { return map.can_see_through(y, x); };
+    BitGrid function_visible(map.height(), map.width());
+    BitGrid policy_visible(map.height(), map.width());
+    const uint32_t range = 15;
+
+    auto start = std::chrono::steady_clock::now();
+    for (const auto& origin : origins) {
+        Fov::shadowcast(origin, range, map.width(), map.height(),
+            [&predicate](int64_t y, int64_t x) { return !predicate(y, x); },
+            [&function_visible](int64_t y, int64_t x) { function_visible.set(y, x); });
+    }
+    auto function_time = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    for (const auto& origin : origins) {
+        map.field_of_view<LosPolicy::SeeThrough>(origin, range, policy_visible);
+    }
+    auto policy_time = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "Range " << range << " field of view: " << function_time / origins.size() << " us with std::function, "
+              << policy_time / origins.size() << " us with LosPolicy::SeeThrough"
+              << (function_visible.words() == policy_visible.words() ? "" : " (DIFFERENT RESULTS)") << std::endl;
+}
+
+// has_line_of_sight has to give the same answer as looking the target up from the full field of view
+static bool check_point_to_point(size_t side, uint32_t seed) {
+    Map map = make_map(side, seed);
+    std::mt19937 rng(seed);
+    bool ok = true;
+
+    for (int i = 0; i < 100; i++) {
+        coordinates<size_t> a(rng() % side, rng() % side);
+        const uint32_t range = 1 + rng() % 12;
+        std::vector<coordinates<size_t>> visible = map.line_of_sight_check<LosPolicy::SeeThrough>(a, range);
+
+        for (size_t y = 0; y < side; y++) {
+            for (size_t x = 0; x < side; x++) {
+                const bool in_view = std::binary_search(visible.begin(), visible.end(), coordinates<size_t>(x, y));
+                if (map.has_line_of_sight<LosPolicy::SeeThrough>(a, {x, y}, range) != in_view) {
+                    std::cout << "Line of sight from (" << a.x << ", " << a.y << ") to (" << x << ", " << y << ") range " << range
+                              << " doesn't match the field of view" << std::endl;
+                    ok = false;
+                }
+            }
+        }
+    }
+    return ok;
+}
+
+// Time of checking the line of sight to a set of targets one by one compared to looking them up from the full view
+static void benchmark_point_to_point(Map& map, const std::vector<coordinates<size_t>>& origins) {
+    const uint32_t range = 15;
+    std::mt19937 rng(1);
+    size_t seen = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (const auto& origin : origins) {
+        std::vector<coordinates<size_t>> visible = map.line_of_sight_check<LosPolicy::ShootThrough>(origin, range);
+        for (int i = 0; i < 10; i++) {
+            coordinates<size_t> target(origin.x + rng() % 21 - 10, origin.y + rng() % 21 - 10);
+            seen += std::find(visible.begin(), visible.end(), target) != visible.end();
+        }
+    }
+    auto full_time = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+    rng.seed(1);
+    start = std::chrono::steady_clock::now();
+    for (const auto& origin : origins) {
+        for (int i = 0; i < 10; i++) {
+            coordinates<size_t> target(origin.x + rng() % 21 - 10, origin.y + rng() % 21 - 10);
+            seen -= map.los_check_from_A_to_B(origin, target, range);
+        }
+    }
+    auto point_time = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "10 range " << range << " line of sight checks: " << full_time / origins.size() << " us from the full view, "
+              << point_time / origins.size() << " us point to point" << (seen == 0 ? "" : " (DIFFERENT RESULTS)") << std::endl;
+}
+
+// What Game::update_visible_tiles used to do: the views of all units concatenated, sorted and the duplicates erased
+static std::vector<coordinates<size_t>> all_visible(Map& map, const std::vector<Unit*>& units, uint32_t range) {
+    std::vector<coordinates<size_t>> visible;
+    for (Unit* unit : units) {
+        std::vector<coordinates<size_t>> unit_visible = map.tiles_unit_sees(map.get_unit_location(unit), range);
+        visible.insert(visible.end(), unit_visible.begin(), unit_visible.end());
+    }
+    std::sort(visible.begin(), visible.end());
+    visible.erase(std::unique(visible.begin(), visible.end()), visible.end());
+    return visible;
+}
+
+// Moves a random unit to a random free tile
+static void move_random_unit(Map& map, std::vector<Unit*>& units, std::mt19937& rng) {
+    Unit* unit = units[rng() % units.size()];
+    coordinates<size_t> target(rng() % map.width(), rng() % map.height());
+    if (map.can_move_to_coords(target.y, target.x)) {
+        map.move_unit(map.get_unit_location(unit), target);
+    }
+}
+
+static bool check_team_visibility(size_t side, uint32_t seed) {
+    Map map = make_map(side, seed);
+    std::mt19937 rng(seed);
+    std::vector<Unit> team(10, Unit("unit"));
+    std::vector<Unit*> units;
+    for (Unit& unit : team) {
+        coordinates<size_t> location(rng() % side, rng() % side);
+        while (!map.can_move_to_coords(location.y, location.x)) location = {rng() % side, rng() % side};
+        map.add_unit(location.y, location.x, &unit);
+        units.push_back(&unit);
+    }
+
+    TeamVisibility visibility;
+    bool ok = true;
+    for (int step = 0; step < 100; step++) {
+        if (step % 10 == 9) {
+            map.update_terrain(rng() % 2 ? '#' : '.', rng() % side, rng() % side);
+        } else if (step % 10 == 5) {
+            units.erase(units.begin() + rng() % units.size()); // a unit dies
+        } else {
+            move_random_unit(map, units, rng);
+        }
+        if (units.empty()) break;
+
+        visibility.update(map, units, 6);
+        std::vector<coordinates<size_t>> expected = all_visible(map, units, 6);
+        ok &= visibility.visible_tiles() == expected;
+        for (size_t y = 0; y < side; y++) {
+            for (size_t x = 0; x < side; x++) {
+                ok &= visibility.is_visible(y, x) == std::binary_search(expected.begin(), expected.end(), coordinates<size_t>(x, y));
+            }
+        }
+    }
+    return ok;
+}
+
+// Time of updating what a team of 100 units sees after one of them moves
+static void benchmark_team_visibility(Map& map, std::vector<Unit>& team, std::mt19937& rng) {
+    std::vector<Unit*> units;
+    for (Unit& unit : team) {
+        coordinates<size_t> location(rng() % map.width(), rng() % map.height());
+        while (!map.can_move_to_coords(location.y, location.x)) location = {rng() % map.width(), rng() % map.height()};
+        map.add_unit(location.y, location.x, &unit);
+        units.push_back(&unit);
+    }
+    const uint32_t range = 10;
+    const int moves = 100;
+    TeamVisibility visibility;
+    visibility.update(map, units, range);
+
+    double full_time = 0, incremental_time = 0;
+    bool same = true;
+    for (int i = 0; i < moves; i++) {
+        move_random_unit(map, units, rng);
+
+        auto start = std::chrono::steady_clock::now();
+        std::vector<coordinates<size_t>> full = all_visible(map, units, range);
+        full_time += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+        start = std::chrono::steady_clock::now();
+        visibility.update(map, units, range);
+        const std::vector<coordinates<size_t>>& incremental = visibility.visible_tiles();
+        incremental_time += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+        same &= full == incremental;
+    }
+
+    std::cout << "Team of " << units.size() << " units, one moves: " << full_time / moves << " us recalculating every view, "
+              << incremental_time / moves << " us incrementally"
+              << (same ? "" : " (DIFFERENT RESULTS)") << std::endl;
+}
+
+// The cached results have to stay the same as the field of view, which isn't cached, when the terrain changes between the checks
+static bool check_fov_cache(size_t side, uint32_t seed) {
+    Map map = make_map(side, seed);
+    std::mt19937 rng(seed);
+    bool ok = true;
+
+    for (int i = 0; i < 300; i++) {
+        if (i % 20 == 19) map.update_terrain(rng() % 2 ? '#' : '.', rng() % side, rng() % side);
+        // Few origins so that most of the checks are repeats
+        coordinates<size_t> origin(rng() % 5, rng() % 5);
+        const uint32_t range = 4 + rng() % 3;
+
+        BitGrid expected(side, side);
+        map.field_of_view<LosPolicy::SeeThrough>(origin, range, expected);
+        std::vector<coordinates<size_t>> visible = map.tiles_unit_sees(origin, range);
+        ok &= visible.size() == expected.count();
+        for (const auto& coords : visible) {
+            ok &= expected.test(coords);
+        }
+    }
+    ok &= map.fov_cache().hits() > 0;
+    return ok;
+}
+
+// Time of the same line of sight checks the first time and when they're repeated
+static void benchmark_fov_cache(Map& map, const std::vector<coordinates<size_t>>& origins) {
+    const uint32_t range = 12;
+    map.fov_cache().clear();
+
+    auto start = std::chrono::steady_clock::now();
+    for (const auto& origin : origins) {
+        map.tiles_can_shoot_on(origin, range);
+    }
+    auto first_time = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    for (const auto& origin : origins) {
+        map.tiles_can_shoot_on(origin, range);
+    }
+    auto repeat_time = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "Range " << range << " line of sight check: " << first_time / origins.size() << " us the first time, "
+              << repeat_time / origins.size() << " us repeated (" << map.fov_cache().hits() << " hits, "
+              << map.fov_cache().misses() << " misses, " << map.fov_cache().stored_tiles() << " tiles stored)" << std::endl;
+}
+
+// Puts a unit on every 10th tile of the map on average
+static std::vector<Unit> add_units(Map& map, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::vector<Unit> units(map.width() * map.height() / 10, Unit("unit"));
+    for (Unit& unit : units) {
+        map.add_unit(rng() % map.height(), rng() % map.width(), &unit);
+    }
+    return units;
+}
+
+// What WeaponAction and HealingAction used to do: all the tiles of the area of effect, filtered for units
+static std::vector<coordinates<size_t>> filtered_aoe(Map& map, const coordinates<size_t>& location, uint32_t range) {
+    std::vector<coordinates<size_t>> unit_coords;
+    for (const auto& coords : map.get_aoe_affected_coords(location, range)) {
+        if (map.has_unit(coords)) unit_coords.push_back(coords);
+    }
+    return unit_coords;
+}
+
+static bool check_aoe_units(size_t side, uint32_t seed) {
+    Map map = make_map(side, seed);
+    std::vector<Unit> units = add_units(map, seed);
+    std::mt19937 rng(seed);
+    bool ok = true;
+
+    for (int i = 0; i < 200; i++) {
+        coordinates<size_t> location(rng() % side, rng() % side);
+        const uint32_t range = rng() % 6;
+        ok &= map.get_aoe_affected_unit_coords(location, range) == filtered_aoe(map, location, range);
+    }
+    return ok;
+}
+
+static void benchmark_aoe_units(Map& map, const std::vector<coordinates<size_t>>& origins) {
+    std::vector<Unit> units = add_units(map, 3);
+    std::cout << "  aoe    all tiles filtered    units only" << std::endl;
+    for (uint32_t range : {1, 2, 3}) {
+        size_t filtered_units = 0, units_only = 0;
+        map.fov_cache().clear();
+
+        auto start = std::chrono::steady_clock::now();
+        for (const auto& origin : origins) {
+            filtered_units += filtered_aoe(map, origin, range).size();
+        }
+        auto filtered_time = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+        start = std::chrono::steady_clock::now();
+        for (const auto& origin : origins) {
+            units_only += map.get_aoe_affected_unit_coords(origin, range).size();
+        }
+        auto units_time = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+        std::cout << std::setw(5) << range << std::setw(16) << filtered_time / origins.size() << " us"
+                  << std::setw(12) << units_time / origins.size() << " us"
+                  << (filtered_units == units_only ? "" : " (DIFFERENT RESULTS)") << std::endl;
+    }
+    for (size_t y = 0; y < map.height(); y++) {
+        for (size_t x = 0; x < map.width(); x++) {
+            map.remove_unit(y, x);
+        }
+    }
+}
+
+static std::vector<Unit*> place_team(Map& map, std::vector<Unit>& team, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::vector<Unit*> units;
+    for (Unit& unit : team) {
+        coordinates<size_t> location(rng() % map.width(), rng() % map.height());
+        while (!map.can_move_to_coords(location.y, location.x)) location = {rng() % map.width(), rng() % map.height()};
+        map.add_unit(location.y, location.x, &unit);
+        units.push_back(&unit);
+    }
+    return units;
+}
+
+// The combined views have to be the same with any amount of jobs
+static bool check_parallel_views(uint32_t seed) {
+    Map map = make_map(100, seed);
+    std::vector<Unit> team(200, Unit("unit"));
+    std::vector<Unit*> units = place_team(map, team, seed);
+    std::vector<coordinates<size_t>> locations;
+    for (Unit* unit : units) {
+        locations.push_back(map.get_unit_location(unit));
+    }
+
+    BitGrid serial(100, 100);
+    map.field_of_view<LosPolicy::SeeThrough>(locations, 8, serial);
+    TeamVisibility serial_team;
+    serial_team.update(map, units, 8);
+
+    bool ok = true;
+    for (size_t jobs : {1, 2, 3, 8}) {
+        ThreadPool pool(jobs);
+        BitGrid parallel(100, 100);
+        map.field_of_view<LosPolicy::SeeThrough>(locations, 8, parallel, &pool);
+        ok &= parallel.words() == serial.words();
+
+        TeamVisibility parallel_team;
+        parallel_team.update(map, units, 8, &pool);
+        ok &= parallel_team.visible_tiles() == serial_team.visible_tiles();
+        ok &= parallel_team.visible_grid().words() == serial.words();
+    }
+    return ok;
+}
+
+// Time of calculating what a team of 500 units sees from nothing, like at the start of the game. The Game calculates
+// the views with TeamVisibility on its own pool, the combined field of view is timed for comparison
+static void benchmark_parallel_views() {
+    const uint32_t range = unit_consts.visual_range;
+    std::cout << " jobs    field of view              Game" << std::endl;
+    std::vector<coordinates<size_t>> serial;
+    for (size_t jobs : {1, 2, 4, 8}) {
+        Map map = make_map(512, 512);
+        std::vector<Unit> team(500, Unit("unit"));
+        std::vector<Unit*> units = place_team(map, team, 512);
+        std::vector<coordinates<size_t>> locations;
+        for (Unit* unit : units) {
+            locations.push_back(map.get_unit_location(unit));
+            map.remove_unit(locations.back());
+        }
+
+        ThreadPool pool(jobs);
+        BitGrid visible(512, 512);
+        auto start = std::chrono::steady_clock::now();
+        map.field_of_view<LosPolicy::SeeThrough>(locations, range, visible, &pool);
+        auto grid_time = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+        // The game copies the map, so nothing is cached yet
+        Game game(map);
+        Team game_team;
+        const int team_id = game_team.get_id();
+        game.add_team(game_team);
+        for (const coordinates<size_t>& location : locations) game.add_unit(team_id, Unit("unit"), location);
+        game.set_visibility_jobs(jobs);
+        start = std::chrono::steady_clock::now();
+        game.init_game();
+        auto game_time = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+        std::vector<coordinates<size_t>> tiles = game.get_visible_tiles();
+        std::sort(tiles.begin(), tiles.end());
+        if (jobs == 1) serial = tiles;
+        std::cout << std::setw(5) << jobs << std::setw(14) << grid_time << " us" << std::setw(14) << game_time << " us"
+                  << (tiles == serial && visible.count() == serial.size() ? "" : " (DIFFERENT RESULTS)") << std::endl;
+    }
+}
+
+void fov_test() {
+    bool ok = true;
+    for (uint32_t seed = 1; seed <= 5; seed++) {
+        ok &= check_symmetry(40, seed);
+    }
+    std::cout << (ok ? "Field of view is symmetric" : "Field of view is NOT symmetric") << std::endl;
+    ok = true;
+    for (uint32_t seed = 1; seed <= 5; seed++) {
+        ok &= check_point_to_point(30, seed);
+    }
+    std::cout << (ok ? "Point to point line of sight matches the field of view" : "Point to point line of sight DOESN'T match the field of view") << std::endl;
+    ok = true;
+    for (uint32_t seed = 1; seed <= 5; seed++) {
+        ok &= check_team_visibility(30, seed);
+    }
+    std::cout << (ok ? "Team visibility matches the views of the units" : "Team visibility DOESN'T match the views of the units") << std::endl;
+    ok = true;
+    for (uint32_t seed = 1; seed <= 5; seed++) {
+        ok &= check_fov_cache(20, seed);
+    }
+    std::cout << (ok ? "Cached line of sight checks match the field of view" : "Cached line of sight checks DON'T match the field of view") << std::endl;
+    std::cout << (check_range_tables() ? "Disc tables match the radius" : "Disc tables DON'T match the radius") << std::endl;
+    ok = true;
+    for (uint32_t seed = 1; seed <= 5; seed++) {
+        ok &= check_aoe_units(40, seed);
+    }
+    std::cout << (ok ? "Area of effect units match the filtered area of effect" : "Area of effect units DON'T match the filtered area of effect") << std::endl;
+    ok = true;
+    for (uint32_t seed = 1; seed <= 3; seed++) {
+        ok &= check_parallel_views(seed);
+    }
+    std::cout << (ok ? "Views calculated in parallel match the serial views" : "Views calculated in parallel DON'T match the serial views") << std::endl;
+    std::cout << (check_bit_kernels() ? "Bit layer kernels match combining the bits one by one" : "Bit layer kernels DON'T match combining the bits one by one") << std::endl;
+    std::cout << (check_open_map() ? "Nothing blocks the view on an empty map" : "Tiles are missing from the view on an empty map") << std::endl;
+    std::cout << (check_visibility_changes() ? "Redrawing the visibility changes gives the visible tiles" : "Redrawing the visibility changes DOESN'T give the visible tiles") << std::endl;
+
+    Map map = make_map(256, 256);
+    std::mt19937 rng(256);
+    std::vector<coordinates<size_t>> origins;
+    for (int i = 0; i < 200; i++) {
+        origins.emplace_back(40 + rng() % 176, 40 + rng() % 176);
+    }
+    auto see_through = [&map](int64_t y, int64_t x) { return map.can_see_through(y, x); };
+
+    std::cout << " range    ray fan     shadowcasting    tiles (ray fan / shadowcasting)" << std::endl;
+    for (uint32_t range : {5, 10, 15, 20, 25, 30}) {
+        size_t fan_tiles = 0, shadow_tiles = 0;
+
+        auto start = std::chrono::steady_clock::now();
+        for (const auto& origin : origins) {
+            fan_tiles += ray_fan(map, origin, range + 1, see_through).size();
+        }
+        auto fan_time = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+        start = std::chrono::steady_clock::now();
+        for (const auto& origin : origins) {
+            shadow_tiles += map.tiles_unit_sees(origin, range).size();
+        }
+        auto shadow_time = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+        std::cout << std::setw(6) << range
+                  << std::setw(10) << fan_time / origins.size() << " us"
+                  << std::setw(12) << shadow_time / origins.size() << " us"
+                  << std::setw(12) << fan_tiles / origins.size() << " / " << shadow_tiles / origins.size() << std::endl;
+    }
+
+    benchmark_policy(map, origins);
+    benchmark_point_to_point(map, origins);
+    benchmark_fov_cache(map, origins);
+    benchmark_bit_kernels();
+    benchmark_aoe_units(map, origins);
+    benchmark_parallel_views();
+
+    std::vector<Unit> team(100, Unit("unit"));
+    benchmark_team_visibility(map, team, rng);
+}
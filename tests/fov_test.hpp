@@ -0,0 +1,6 @@
+#ifndef FOV_TEST_HPP
+#define FOV_TEST_HPP
+
+void fov_test();
+
+#endif //FOV_TEST_HPP
@@ -0,0 +1,169 @@
+#include <iostream>
+#include <algorithm>
+#include <random>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include "game_state_test.hpp"
+#include "game.hpp"
+#include "game_state.hpp"
+#include "action.hpp"
+#include "item.hpp"
+#include "const_items.hpp"
+
+/*
+ * Test of GameState. Random actions of the units of a game (movements, single target and area of effect attacks,
+ * healing and building) are executed in the game and made in a GameState copied from it, and after every action
+ * the state has to be the same as a new copy of the game. The weapons always hit, so the outcomes don't depend on
+ * the random numbers. Making the moves and taking them all back again has to give the same states in reverse, and
+ * a copy has to stay the same while the state it was copied from changes.
+ *
+ * Also prints how long copying a GameState and making and taking back a move take.
+ */
+
+// A game with two teams of <team_size> units on a map with random walls, every unit carries two weapons, a healing item
+// and a building part
+static std::unique_ptr<Game> make_game(size_t side, size_t team_size, uint32_t seed) {
+    auto game = std::make_unique<Game>(side, side);
+    Map& map = game->get_map();
+    std::mt19937 rng(seed);
+    for (size_t y = 0; y < side; y++) {
+        for (size_t x = 0; x < side; x++) {
+            if (rng() % 10 == 0) map.update_terrain('#', y, x);
+        }
+    }
+
+    const std::vector<std::shared_ptr<const Item>> parts = {
+        ConstItem::turret_legs, ConstItem::turret_barrel, ConstItem::medic_tent_tent, ConstItem::medic_tent_medkit
+    };
+    for (int t = 0; t < 2; t++) {
+        Team team;
+        for (size_t i = 0; i < team_size; i++) {
+            Unit unit("unit");
+            unit.add_item(std::make_shared<Weapon>("rifle", 100, 30, 10));
+            unit.add_item(std::make_shared<Weapon>("grenade", 100, 40, 20, 2));
+            if (i % 2 == 0) {
+                unit.add_item(std::make_shared<HealingItem>("medkit", 25));
+            } else {
+                unit.add_item(std::make_shared<HealingItem>("first aid station", 15, 1));
+            }
+            unit.add_item(parts[rng() % parts.size()]);
+            team.add_unit(unit);
+        }
+        game->add_team(team);
+    }
+    for (Team& team : game->get_teams()) {
+        for (Unit& unit : team.get_units()) {
+            coordinates<size_t> location;
+            do {
+                location = {rng() % side, rng() % side};
+            } while (!map.can_move_to_coords(location.y, location.x));
+            map.add_unit(location, &unit);
+        }
+    }
+    return game;
+}
+
+// A random action of a random unit: a movement nearby or using one of its items on a unit or a tile nearby
+static std::shared_ptr<Action> random_action(Game& game, std::mt19937& rng) {
+    std::vector<Unit*> units = game.get_units();
+    Map& map = game.get_map();
+    Unit& unit = *units[rng() % units.size()];
+    const coordinates<size_t> location = map.get_unit_location(&unit);
+
+    coordinates<size_t> target;
+    if (rng() % 2 == 0) {
+        target = map.get_unit_location(units[rng() % units.size()]);
+    } else {
+        const int64_t x = int64_t(location.x) + int64_t(rng() % 9) - 4;
+        const int64_t y = int64_t(location.y) + int64_t(rng() % 9) - 4;
+        target = {size_t(std::clamp<int64_t>(x, 0, map.width() - 1)), size_t(std::clamp<int64_t>(y, 0, map.height() - 1))};
+    }
+
+    if (rng() % 3 == 0) return std::make_shared<MovementAction>(location, target, unit);
+    return unit.get_inventory()[rng() % unit.get_inventory().size()]->get_action(target, unit);
+}
+
+static bool check_same_as_game() {
+    std::unique_ptr<Game> game = make_game(24, 12, 3);
+    GameState state(*game);
+    std::mt19937 rng(7);
+    bool ok = state == GameState(*game);
+    for (int i = 0; i < 500; i++) {
+        std::shared_ptr<Action> action = random_action(*game, rng);
+        state.make(state.move_of(*action), rng);
+        game->execute_action(action);
+        ok &= state == GameState(*game);
+    }
+    // Something has to have happened to every kind of state
+    bool damaged = false;
+    for (const GameState::UnitState& unit : state.units()) {
+        damaged |= unit.hp < unit_consts.max_hp;
+    }
+    return ok && damaged && !state.buildings().empty();
+}
+
+static bool check_make_unmake() {
+    std::unique_ptr<Game> game = make_game(24, 12, 11);
+    const GameState start(*game);
+    GameState state = start;
+    std::mt19937 rng(13);
+
+    std::vector<GameState> history;
+    for (int i = 0; i < 500; i++) {
+        history.push_back(state);
+        state.make(state.move_of(*random_action(*game, rng)), rng);
+        // The actions are only made on the state, the game doesn't change
+        if (i % 50 == 0) state.change_hp(rng() % state.units().size(), -10);
+    }
+
+    bool ok = state.depth() == 500 && !(state == start);
+    while (state.depth() > 0) {
+        state.unmake();
+        ok &= state == history.back();
+        history.pop_back();
+    }
+    return ok && state == start && start == GameState(*game);
+}
+
+static void benchmark_game_state() {
+    std::unique_ptr<Game> game = make_game(128, 200, 5);
+    std::mt19937 rng(17);
+
+    auto start = std::chrono::steady_clock::now();
+    GameState state(*game);
+    std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << "GameState of 400 units on a 128x128 map: " << elapsed.count() << " us to copy from the game, ";
+
+    const int copies = 1000;
+    size_t units = 0;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < copies; i++) {
+        GameState copy = state;
+        units += copy.units().size();
+    }
+    elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << elapsed.count() / copies << " us to copy (" << units / copies << " units)" << std::endl;
+
+    std::vector<GameState::Move> moves;
+    for (int i = 0; i < 1000; i++) {
+        moves.push_back(state.move_of(*random_action(*game, rng)));
+    }
+    const int rounds = 1000;
+    start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++) {
+        for (const GameState::Move& move : moves) {
+            state.make(move, rng);
+        }
+        while (state.depth() > 0) state.unmake();
+    }
+    elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << "Making and taking back a move: " << elapsed.count() * 1000 / (rounds * moves.size()) << " ns" << std::endl;
+}
+
+void game_state_test() {
+    std::cout << (check_same_as_game() ? "GameState makes the same changes as the actions" : "GameState DOESN'T make the same changes as the actions") << std::endl;
+    std::cout << (check_make_unmake() ? "Taking back the moves gives the same states" : "Taking back the moves DOESN'T give the same states") << std::endl;
+    benchmark_game_state();
+}
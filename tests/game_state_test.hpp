@@ -0,0 +1,6 @@
+#ifndef GAME_STATE_TEST_HPP
+#define GAME_STATE_TEST_HPP
+
+void game_state_test();
+
+#endif //GAME_STATE_TEST_HPP
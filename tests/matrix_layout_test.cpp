@@ -0,0 +1,120 @@
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <deque>
+#include <chrono>
+#include <cmath>
+#include <string>
+
+#include "matrix_layout_test.hpp"
+#include "matrix.hpp"
+
+/*
+ * Benchmark of the Matrix memory layouts. Runs the two access patterns that matter for the map,
+ * a 4-neighbour flood fill (like the movement searches) and a fan of Bresenham rays (like the LoS check),
+ * on random maps from 64x64 to 4096x4096 and prints the time each layout takes.
+ * The checksums should be equal for every layout of the same map size.
+ */
+
+static const uint8_t wall = 1;
+
+template<typename Layout>
+static Matrix<uint8_t, Layout> make_terrain(size_t side) {
+    Matrix<uint8_t, Layout> terrain(side, side, 0);
+    std::mt19937 rng(side);
+    for (size_t y = 0; y < side; y++) {
+        for (size_t x = 0; x < side; x++) {
+            if (rng() % 5 == 0) terrain(y, x) = wall;
+        }
+    }
+    return terrain;
+}
+
+// Flood fill from the center of the map, returns the amount of tiles reached
+template<typename Layout>
+static size_t flood(const Matrix<uint8_t, Layout>& terrain) {
+    const size_t side = terrain.width();
+    Matrix<uint8_t, Layout> visited(side, side, 0);
+    std::deque<coordinates<size_t>> queue;
+    queue.emplace_back(side / 2, side / 2);
+    visited(side / 2, side / 2) = 1;
+    size_t reached = 0;
+
+    const int32_t dx[] = {0, 1, 0, -1};
+    const int32_t dy[] = {-1, 0, 1, 0};
+    while (!queue.empty()) {
+        coordinates<size_t> current = queue.front();
+        queue.pop_front();
+        reached++;
+
+        for (int i = 0; i < 4; i++) {
+            size_t x = current.x + dx[i];
+            size_t y = current.y + dy[i];
+            // size_t wraps around when going below 0, so this checks both ends
+            if (x >= side || y >= side) continue;
+            if (visited(y, x) || terrain(y, x) == wall) continue;
+            visited(y, x) = 1;
+            queue.emplace_back(x, y);
+        }
+    }
+    return reached;
+}
+
+// Casts rays from <origins> random origins to every tile on a square ring of radius <range>,
+// returns the amount of tiles the rays went through
+template<typename Layout>
+static size_t ray_fan(const Matrix<uint8_t, Layout>& terrain, size_t origins, int64_t range) {
+    const int64_t side = terrain.width();
+    std::mt19937 rng(1);
+    size_t seen = 0;
+
+    for (size_t i = 0; i < origins; i++) {
+        const int64_t x0 = rng() % side;
+        const int64_t y0 = rng() % side;
+
+        for (int64_t k = -range; k <= range; k++) {
+            const int64_t ends[4][2] = {{x0 + k, y0 - range}, {x0 + k, y0 + range}, {x0 - range, y0 + k}, {x0 + range, y0 + k}};
+            for (const auto& end : ends) {
+                int64_t x = x0, y = y0;
+                const int64_t dx = std::abs(end[0] - x0), sx = x0 < end[0] ? 1 : -1;
+                const int64_t dy = -std::abs(end[1] - y0), sy = y0 < end[1] ? 1 : -1;
+                int64_t error = dx + dy;
+                while (x != end[0] || y != end[1]) {
+                    const int64_t e2 = 2 * error;
+                    if (e2 >= dy) { error += dy; x += sx; }
+                    if (e2 <= dx) { error += dx; y += sy; }
+                    if (x < 0 || y < 0 || x >= side || y >= side) break;
+                    seen++;
+                    if (terrain(y, x) == wall) break;
+                }
+            }
+        }
+    }
+    return seen;
+}
+
+template<typename Layout>
+static void run_layout(const std::string& name, size_t side) {
+    Matrix<uint8_t, Layout> terrain = make_terrain<Layout>(side);
+
+    auto start = std::chrono::steady_clock::now();
+    size_t reached = flood(terrain);
+    auto flood_end = std::chrono::steady_clock::now();
+    size_t seen = ray_fan(terrain, 2000, 30);
+    auto fan_end = std::chrono::steady_clock::now();
+
+    std::cout << std::setw(6) << side << std::setw(12) << name
+              << std::setw(12) << std::chrono::duration<double, std::milli>(flood_end - start).count()
+              << std::setw(12) << std::chrono::duration<double, std::milli>(fan_end - flood_end).count()
+              << "    " << reached << "/" << seen << std::endl;
+}
+
+void matrix_layout_test() {
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "  side      layout  flood (ms)    rays (ms)    checksum" << std::endl;
+    for (size_t side = 64; side <= 4096; side *= 2) {
+        run_layout<MatrixLayout::RowMajor>("row-major", side);
+        run_layout<MatrixLayout::Tiled<8>>("tiled 8x8", side);
+        run_layout<MatrixLayout::Morton>("morton", side);
+    }
+}
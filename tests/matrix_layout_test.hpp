@@ -0,0 +1,6 @@
+#ifndef MATRIX_LAYOUT_TEST_HPP
+#define MATRIX_LAYOUT_TEST_HPP
+
+void matrix_layout_test();
+
+#endif //MATRIX_LAYOUT_TEST_HPP
@@ -0,0 +1,390 @@
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <queue>
+#include <chrono>
+#include <limits>
+#include <vector>
+
+#include "pathfinding_test.hpp"
+#include "map.hpp"
+#include "flow_field.hpp"
+
+/*
+ * Test of Map::find_path and Map::fastest_movement_to_target. On random maps with walls and mud,
+ * the cost of every A* path is compared to the cost given by a plain Dijkstra search over the whole map,
+ * and the tile returned by fastest_movement_to_target is checked to be on a cheapest path and within the movement range.
+ * Also prints how long the A* queries take compared to the full Dijkstra.
+ *
+ * The hierarchical pathfinder is checked the same way: the abstract path has to exist exactly when a grid path
+ * exists, also after the terrain has been changed, and its refined cost is compared to the optimal one.
+ * The region labels are checked against the reachability found by the Dijkstra while the terrain is edited.
+ * The flow field distances are checked against the Dijkstra from every tile, and the time it takes a whole team
+ * to pick their movement with a flow field is compared to a fastest_movement_to_target search per unit.
+ */
+
+static const size_t unreachable = std::numeric_limits<size_t>::max();
+
+static Map make_map(size_t side, uint32_t seed) {
+    Map map(side, side);
+    std::mt19937 rng(seed);
+    for (size_t y = 0; y < side; y++) {
+        for (size_t x = 0; x < side; x++) {
+            uint32_t roll = rng() % 10;
+            if (roll < 2) map.update_terrain('#', y, x);
+            else if (roll < 3) map.update_terrain('-', y, x);
+        }
+    }
+    return map;
+}
+
+// Dijkstra from <from> to every tile, returns the cost of the cheapest path to each tile
+static std::vector<size_t> reference_costs(Map& map, const coordinates<size_t>& from) {
+    using Entry = std::pair<size_t, size_t>;
+    const size_t width = map.width();
+    std::vector<size_t> cost(width * map.height(), unreachable);
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue;
+    cost[from.y * width + from.x] = 0;
+    queue.emplace(0, from.y * width + from.x);
+
+    const int32_t dx[] = {0, 1, 0, -1};
+    const int32_t dy[] = {-1, 0, 1, 0};
+    while (!queue.empty()) {
+        auto [current_cost, idx] = queue.top();
+        queue.pop();
+        if (current_cost != cost[idx]) continue;
+
+        for (int i = 0; i < 4; i++) {
+            size_t x = idx % width + dx[i];
+            size_t y = idx / width + dy[i];
+            if (x >= width || y >= map.height() || !map.can_move_to_coords(y, x)) continue;
+            size_t next_cost = current_cost + map.movement_cost(y, x);
+            if (next_cost < cost[y * width + x]) {
+                cost[y * width + x] = next_cost;
+                queue.emplace(next_cost, y * width + x);
+            }
+        }
+    }
+    return cost;
+}
+
+static coordinates<size_t> random_free_tile(Map& map, std::mt19937& rng) {
+    while (true) {
+        coordinates<size_t> coords(rng() % map.width(), rng() % map.height());
+        if (map.can_move_to_coords(coords)) return coords;
+    }
+}
+
+static bool check_map(size_t side, uint32_t seed, size_t queries) {
+    Map map = make_map(side, seed);
+    std::mt19937 rng(seed + 1);
+    bool ok = true;
+
+    for (size_t i = 0; i < queries; i++) {
+        coordinates<size_t> from = random_free_tile(map, rng);
+        coordinates<size_t> to = random_free_tile(map, rng);
+        std::vector<size_t> cost = reference_costs(map, from);
+        std::vector<coordinates<size_t>> path = map.find_path(from, to);
+
+        size_t path_cost = path.empty() ? unreachable : 0;
+        coordinates<size_t> previous = from;
+        for (const auto& coords : path) {
+            size_t step = (coords.x > previous.x ? coords.x - previous.x : previous.x - coords.x)
+                        + (coords.y > previous.y ? coords.y - previous.y : previous.y - coords.y);
+            if (step != 1 || !map.can_move_to_coords(coords)) ok = false;
+            path_cost += map.movement_cost(coords);
+            previous = coords;
+        }
+        if (from == to) path_cost = 0;
+
+        if (path_cost != cost[to.y * side + to.x]) {
+            std::cout << "Wrong path cost from (" << from.x << ", " << from.y << ") to (" << to.x << ", " << to.y
+                      << "): " << path_cost << " expected " << cost[to.y * side + to.x] << std::endl;
+            ok = false;
+        }
+
+        // The chosen tile has to be reachable within the range and on a cheapest path to the target
+        const uint8_t range = 4;
+        coordinates<size_t> movement = map.fastest_movement_to_target(from, to, range);
+        size_t movement_cost = cost[movement.y * side + movement.x];
+        if (movement_cost > range) ok = false;
+        if (cost[to.y * side + to.x] != unreachable && movement != from) {
+            std::vector<size_t> rest = reference_costs(map, movement);
+            if (movement_cost + rest[to.y * side + to.x] != cost[to.y * side + to.x]) ok = false;
+        }
+    }
+    return ok;
+}
+
+static void benchmark(size_t side, size_t queries) {
+    Map map = make_map(side, side);
+    std::mt19937 rng(side);
+    std::vector<std::pair<coordinates<size_t>, coordinates<size_t>>> pairs;
+    for (size_t i = 0; i < queries; i++) {
+        pairs.emplace_back(random_free_tile(map, rng), random_free_tile(map, rng));
+    }
+
+    size_t checksum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (const auto& [from, to] : pairs) {
+        checksum += map.find_path(from, to).size();
+    }
+    auto astar_time = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    for (const auto& [from, to] : pairs) {
+        checksum += reference_costs(map, from)[to.y * side + to.x] != unreachable;
+    }
+    auto dijkstra_time = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << std::setw(6) << side << "x" << std::setw(6) << std::left << side << std::right
+              << std::setw(14) << astar_time / queries << " us"
+              << std::setw(14) << dijkstra_time / queries << " us"
+              << "   (checksum " << checksum << ")" << std::endl;
+}
+
+// The cost of following the waypoints with grid paths between them, unreachable if a piece has no path
+static size_t refined_cost(Map& map, const coordinates<size_t>& from, const std::vector<coordinates<size_t>>& waypoints) {
+    size_t cost = 0;
+    coordinates<size_t> previous = from;
+    for (const auto& waypoint : waypoints) {
+        std::vector<coordinates<size_t>> piece = map.find_path(previous, waypoint);
+        if (piece.empty()) return unreachable;
+        for (const auto& coords : piece) cost += map.movement_cost(coords);
+        previous = waypoint;
+    }
+    return cost;
+}
+
+static bool check_hierarchical(size_t side, uint32_t seed, size_t queries, double& worst_ratio) {
+    Map map = make_map(side, seed);
+    map.enable_hierarchical_pathfinding(8);
+    HierarchicalPathfinder pathfinder(map, 8);
+    std::mt19937 rng(seed + 1);
+    bool ok = true;
+
+    for (size_t i = 0; i < queries; i++) {
+        // Change some terrain every few queries so the incremental rebuild gets tested too
+        if (i % 4 == 0) {
+            for (int j = 0; j < 10; j++) {
+                const char terrain = "#.-"[rng() % 3];
+                const size_t y = rng() % side, x = rng() % side;
+                map.update_terrain(terrain, y, x);
+                pathfinder.mark_dirty(y, x);
+            }
+        }
+
+        coordinates<size_t> from = random_free_tile(map, rng);
+        coordinates<size_t> to = random_free_tile(map, rng);
+        if (from == to) continue;
+
+        const size_t optimal = reference_costs(map, from)[to.y * side + to.x];
+        std::vector<coordinates<size_t>> waypoints = pathfinder.find_abstract_path(map, from, to);
+        const size_t cost = waypoints.empty() ? unreachable : refined_cost(map, from, waypoints);
+
+        if ((optimal == unreachable) != (cost == unreachable)) {
+            std::cout << "Hierarchical path from (" << from.x << ", " << from.y << ") to (" << to.x << ", " << to.y
+                      << ") exists: " << (cost != unreachable) << " expected " << (optimal != unreachable) << std::endl;
+            ok = false;
+        } else if (optimal != unreachable && optimal > 0) {
+            worst_ratio = std::max(worst_ratio, double(cost) / optimal);
+        }
+    }
+    return ok;
+}
+
+static void benchmark_hierarchical(size_t side, size_t queries) {
+    Map map = make_map(side, side);
+    auto start = std::chrono::steady_clock::now();
+    map.enable_hierarchical_pathfinding();
+    HierarchicalPathfinder pathfinder(map);
+    auto build_time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / 2;
+
+    std::mt19937 rng(side);
+    std::vector<std::pair<coordinates<size_t>, coordinates<size_t>>> pairs;
+    for (size_t i = 0; i < queries; i++) {
+        pairs.emplace_back(random_free_tile(map, rng), random_free_tile(map, rng));
+    }
+
+    size_t moved = 0;
+    start = std::chrono::steady_clock::now();
+    for (const auto& [from, to] : pairs) {
+        moved += map.fastest_movement_to_target(from, to, 6) != from;
+    }
+    auto movement_time = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    for (const auto& [from, to] : pairs) {
+        moved += !map.find_path(from, to).empty();
+    }
+    auto astar_time = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+    // Rebuilding a cluster after a terrain change
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < queries; i++) {
+        pathfinder.mark_dirty(rng() % side, rng() % side);
+        // The dirty cluster is rebuilt at the start of the next query, a query to the starting tile itself does nothing else
+        pathfinder.find_abstract_path(map, pairs[i].first, pairs[i].first);
+    }
+    auto rebuild_time = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << std::setw(6) << side << "x" << std::setw(6) << std::left << side << std::right
+              << std::setw(10) << build_time << " ms"
+              << std::setw(12) << movement_time / queries << " us"
+              << std::setw(12) << astar_time / queries << " us"
+              << std::setw(12) << rebuild_time / queries << " us"
+              << "   (" << pathfinder.node_count() << " nodes, moved " << moved << ")" << std::endl;
+}
+
+static bool check_regions(size_t side, uint32_t seed, size_t edits) {
+    Map map = make_map(side, seed);
+    std::mt19937 rng(seed + 1);
+    bool ok = true;
+
+    for (size_t i = 0; i < edits; i++) {
+        // Walls are more common so regions get split too, not just merged
+        const char terrain = "##.-"[rng() % 4];
+        map.update_terrain(terrain, rng() % side, rng() % side);
+
+        if (i % 10 != 0) continue;
+        coordinates<size_t> from = random_free_tile(map, rng);
+        std::vector<size_t> cost = reference_costs(map, from);
+        for (size_t y = 0; y < side; y++) {
+            for (size_t x = 0; x < side; x++) {
+                if (!map.can_move_to_terrain(y, x)) {
+                    ok &= map.region_of(y, x) == 0;
+                } else if (map.are_connected(from, {x, y}) != (cost[y * side + x] != unreachable)) {
+                    std::cout << "Wrong region for (" << x << ", " << y << ") from (" << from.x << ", " << from.y << ")" << std::endl;
+                    ok = false;
+                }
+            }
+        }
+    }
+    return ok;
+}
+
+static bool check_flow_field(size_t side, uint32_t seed) {
+    Map map = make_map(side, seed);
+    std::mt19937 rng(seed + 1);
+    std::vector<coordinates<size_t>> targets;
+    for (int i = 0; i < 3; i++) {
+        targets.push_back(random_free_tile(map, rng));
+    }
+
+    FlowField field;
+    field.build(map, targets);
+    bool ok = true;
+    for (size_t y = 0; y < side; y++) {
+        for (size_t x = 0; x < side; x++) {
+            if (!map.can_move_to_terrain(y, x)) continue;
+
+            std::vector<size_t> cost = reference_costs(map, {x, y});
+            size_t closest = unreachable;
+            for (const auto& target : targets) {
+                closest = std::min(closest, cost[target.y * side + target.x]);
+            }
+            const uint32_t distance = field.distance(y, x);
+            if ((closest == unreachable) != (distance == FlowField::unreachable) || (closest != unreachable && closest != distance)) {
+                ok = false;
+            }
+        }
+    }
+    return ok;
+}
+
+static void benchmark_flow_field(size_t side, size_t team_size) {
+    Map map = make_map(side, side);
+    std::mt19937 rng(side);
+    std::vector<coordinates<size_t>> units, enemies;
+    for (size_t i = 0; i < team_size; i++) {
+        units.push_back(random_free_tile(map, rng));
+        enemies.push_back(random_free_tile(map, rng));
+    }
+
+    size_t moved = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < team_size; i++) {
+        moved += map.fastest_movement_to_target(units[i], enemies[rng() % team_size], 6) != units[i];
+    }
+    auto search_time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    FlowField field;
+    field.build(map, enemies);
+    for (size_t i = 0; i < team_size; i++) {
+        // The step EnemyAI::best_step takes for a unit that isn't retreating, without its tie break on the danger
+        coordinates<size_t> best = units[i];
+        for (const coordinates<size_t>& option : map.possible_tiles_to_move_to3(units[i], 6)) {
+            if (field.distance(option) < field.distance(best)) best = option;
+        }
+        moved += best != units[i];
+    }
+    auto field_time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << std::setw(6) << side << "x" << std::setw(6) << std::left << side << std::right << std::setw(6) << team_size
+              << std::setw(14) << search_time << " ms" << std::setw(14) << field_time << " ms   (moved " << moved << ")" << std::endl;
+}
+
+void pathfinding_test() {
+    bool ok = true;
+    for (uint32_t seed = 1; seed <= 20; seed++) {
+        ok &= check_map(10 + seed * 3, seed, 20);
+    }
+    std::cout << (ok ? "A* paths match the reference Dijkstra" : "A* paths DON'T match the reference Dijkstra") << std::endl;
+
+    std::cout << "   map size      A* query     Dijkstra query" << std::endl;
+    for (size_t side : {32, 64, 128, 256, 512}) {
+        benchmark(side, 200);
+    }
+
+    ok = true;
+    for (uint32_t seed = 1; seed <= 10; seed++) {
+        ok &= check_regions(10 + seed * 4, seed, 200);
+    }
+    std::cout << (ok ? "Region labels match the reachable tiles" : "Region labels DON'T match the reachable tiles") << std::endl;
+
+    // A target that is walled off, the search would have to go through the whole map to find out it can't be reached
+    {
+        Map map(512, 512);
+        for (size_t i = 0; i < 3; i++) {
+            map.update_terrain('#', 500 + i, 499);
+            map.update_terrain('#', 500 + i, 503);
+            map.update_terrain('#', 499, 500 + i);
+            map.update_terrain('#', 503, 500 + i);
+        }
+        auto start = std::chrono::steady_clock::now();
+        bool found = !map.find_path({0, 0}, {501, 501}).empty();
+        auto search_time = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        // The region labels are built on first use, build them before timing
+        (void)map.region_of(0, 0);
+        start = std::chrono::steady_clock::now();
+        found |= map.fastest_movement_to_target({0, 0}, {501, 501}, 4) != coordinates<size_t>(0, 0);
+        auto region_time = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Walled off target on a 512x512 map: " << search_time << " us searching, " << region_time
+                  << " us with the region labels" << (found ? " (WRONG, found a path)" : "") << std::endl;
+    }
+
+    ok = true;
+    for (uint32_t seed = 1; seed <= 5; seed++) {
+        ok &= check_flow_field(10 + seed * 4, seed);
+    }
+    std::cout << (ok ? "Flow field distances match the reference Dijkstra" : "Flow field distances DON'T match the reference Dijkstra") << std::endl;
+
+    std::cout << "   map size    units   search per unit    flow field" << std::endl;
+    for (size_t team_size : {4, 16, 64}) {
+        benchmark_flow_field(256, team_size);
+    }
+
+    ok = true;
+    double worst_ratio = 1;
+    for (uint32_t seed = 1; seed <= 10; seed++) {
+        ok &= check_hierarchical(20 + seed * 6, seed, 40, worst_ratio);
+    }
+    std::cout << (ok ? "Hierarchical paths are found exactly when a grid path exists" : "Hierarchical paths DON'T match the grid paths")
+              << ", worst path is " << worst_ratio << "x the optimal cost" << std::endl;
+
+    std::cout << "   map size       build    HPA* move   A* query    rebuild" << std::endl;
+    for (size_t side : {256, 512, 1024}) {
+        benchmark_hierarchical(side, 50);
+    }
+}
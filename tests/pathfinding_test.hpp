@@ -0,0 +1,6 @@
+#ifndef PATHFINDING_TEST_HPP
+#define PATHFINDING_TEST_HPP
+
+void pathfinding_test();
+
+#endif //PATHFINDING_TEST_HPP
@@ -0,0 +1,174 @@
+#include <iostream>
+#include <algorithm>
+#include <random>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include "unit_storage_test.hpp"
+#include "slot_map.hpp"
+#include "game.hpp"
+#include "team.hpp"
+#include "unit.hpp"
+#include "action.hpp"
+
+/*
+ * Test of the unit storage. A SlotMap has to keep its elements at the same address while others are inserted and erased,
+ * stop finding erased elements through their handles even when the slot is used again, and iterate in the order the
+ * elements were inserted. The units of a Team have to stay at the same address while units are added and removed, and
+ * the handles have to find the same units in the copy of the team a Game keeps. Units added to a running game are on
+ * the map, and the queued actions of a unit removed from the game are skipped.
+ *
+ * Also prints how long finding a unit by its id takes from a big team compared to going through all the units.
+ */
+
+static bool check_slot_map() {
+    SlotMap<int> map;
+    std::vector<SlotHandle> handles;
+    std::vector<int*> addresses;
+    for (int i = 0; i < 1000; i++) {
+        handles.push_back(map.insert(i));
+        addresses.push_back(map.get(handles.back()));
+    }
+
+    // Erase every third element and insert as many new ones, which reuse the erased slots
+    for (int i = 0; i < 1000; i += 3) map.erase(handles[i]);
+    std::vector<SlotHandle> new_handles;
+    for (int i = 0; i < 1000; i += 3) new_handles.push_back(map.insert(1000 + i));
+
+    bool ok = map.size() == 1000;
+    for (int i = 0; i < 1000; i++) {
+        if (i % 3 == 0) {
+            ok &= map.get(handles[i]) == nullptr && !map.contains(handles[i]);
+        } else {
+            ok &= map.get(handles[i]) == addresses[i] && *addresses[i] == i;
+        }
+    }
+    ok &= !map.erase(handles[0]);
+
+    // The elements that are left first, in the order they were inserted, then the new ones
+    std::vector<int> expected;
+    for (int i = 0; i < 1000; i++) if (i % 3 != 0) expected.push_back(i);
+    for (int i = 0; i < 1000; i += 3) expected.push_back(1000 + i);
+    ok &= std::equal(map.begin(), map.end(), expected.begin(), expected.end());
+
+    // The handles of the map find the elements of a copy, and moving the map doesn't move the elements
+    const SlotMap<int> copy = map;
+    for (const SlotHandle& handle : new_handles) ok &= *copy.get(handle) == *map.get(handle) && copy.get(handle) != map.get(handle);
+    SlotMap<int> moved = std::move(map);
+    for (size_t i = 1; i < handles.size(); i += 3) ok &= moved.get(handles[i]) == addresses[i];
+    return ok;
+}
+
+static bool check_team() {
+    Team team;
+    std::vector<int> ids;
+    for (int i = 0; i < 200; i++) {
+        Unit unit("unit");
+        ids.push_back(unit.get_id());
+        team.add_unit(unit);
+    }
+    std::vector<Unit*> addresses;
+    for (int id : ids) addresses.push_back(team.get_unit(id));
+
+    // Reinforcements and losses around the units don't move them
+    std::vector<UnitHandle> removed;
+    for (int i = 0; i < 1000; i++) team.add_unit(Unit("reinforcement"));
+    for (int i = 0; i < 200; i += 2) {
+        removed.push_back(team.get_handle(ids[i]));
+        team.remove_unit(ids[i]);
+    }
+    for (int i = 0; i < 1000; i++) team.add_unit(Unit("reinforcement"));
+
+    bool ok = team.get_units().size() == 2100;
+    for (int i = 0; i < 200; i++) {
+        if (i % 2 == 0) {
+            ok &= team.get_unit(ids[i]) == nullptr && !team.has_unit(ids[i]) && !team.get_handle(ids[i]).valid();
+        } else {
+            ok &= team.get_unit(ids[i]) == addresses[i] && team.get_unit(addresses[i]->get_handle()) == addresses[i];
+        }
+    }
+    for (const UnitHandle& handle : removed) ok &= team.get_unit(handle) == nullptr;
+
+    // The game keeps a copy of the team, the handles of the units have to find the copies
+    Game game(8, 8);
+    game.add_team(team);
+    Team& game_team = game.get_team_by_id(team.get_id());
+    for (int i = 1; i < 200; i += 2) {
+        Unit* unit = game.get_unit(addresses[i]->get_handle());
+        ok &= unit != nullptr && unit != addresses[i] && unit->get_id() == ids[i] && unit == game_team.get_unit(ids[i]);
+    }
+    return ok;
+}
+
+static bool check_game() {
+    Game game(16, 16);
+    Team first;
+    Team second;
+    const int first_id = first.get_id();
+    const int second_id = second.get_id();
+    game.add_team(first);
+    game.add_team(second);
+
+    // Units added to the running game are placed on the map, and a unit can't be added on an occupied tile
+    const UnitHandle a = game.add_unit(first_id, Unit("a"), {1, 1});
+    const UnitHandle b = game.add_unit(first_id, Unit("b"), {3, 1});
+    const UnitHandle c = game.add_unit(second_id, Unit("c"), {10, 10});
+    Map& map = game.get_map();
+    Unit* a_unit = game.get_unit(a);
+    bool ok = a.valid() && b.valid() && c.valid() && !game.add_unit(second_id, Unit("d"), {1, 1}).valid();
+    ok &= map.get_unit({1, 1}) == a_unit && game.get_unit_team_id(a_unit->get_id()) == first_id && a.team_id == first_id;
+
+    // The pointer the map has stays valid while the teams get reinforcements
+    for (size_t x = 0; x < 16; x++) game.add_unit(second_id, Unit("reinforcement"), {x, 15});
+    ok &= map.get_unit({1, 1}) == a_unit && map.get_unit_location(a_unit) == coordinates<size_t>(1, 1);
+
+    // b is removed with a movement queued, the movement is skipped and the other units still move
+    Unit* b_unit = game.get_unit(b);
+    ok &= game.add_action(std::make_shared<MovementAction>(coordinates<size_t>(3, 1), coordinates<size_t>(3, 2), *b_unit), first_id);
+    ok &= game.add_action(std::make_shared<MovementAction>(coordinates<size_t>(1, 1), coordinates<size_t>(1, 2), *a_unit), first_id);
+    const int b_id = b_unit->get_id();
+    ok &= game.remove_unit(b) && !game.remove_unit(b);
+    game.end_team_turns(first_id);
+
+    ok &= game.get_unit(b) == nullptr && !game.get_team_by_id(first_id).has_unit(b_id);
+    ok &= !map.has_unit(1, 3) && !map.has_unit(2, 3);
+    ok &= map.get_unit({1, 2}) == a_unit && game.get_unit(a) == a_unit;
+    ok &= game.get_team_by_id(first_id).get_units().size() == 1 && game.get_team_by_id(second_id).get_units().size() == 17;
+    return ok;
+}
+
+static void benchmark_get_unit() {
+    Team team;
+    std::vector<int> ids;
+    for (int i = 0; i < 10000; i++) {
+        Unit unit("unit");
+        ids.push_back(unit.get_id());
+        team.add_unit(unit);
+    }
+    std::mt19937 rng(3);
+    std::vector<int> lookups;
+    for (int i = 0; i < 10000; i++) lookups.push_back(ids[rng() % ids.size()]);
+
+    size_t found = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int id : lookups) found += team.get_unit(id) != nullptr;
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << "Finding a unit of 10000 by id: " << elapsed.count() / lookups.size() << " ns with the handles, ";
+
+    // How Team::get_unit found the units before
+    const SlotMap<Unit>& units = team.get_units();
+    start = std::chrono::steady_clock::now();
+    for (int id : lookups) {
+        found += std::find_if(units.begin(), units.end(), [id](const Unit& unit) { return unit.get_id() == id; }) != units.end();
+    }
+    elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << elapsed.count() / lookups.size() << " ns going through the units (" << found / 2 << " found)" << std::endl;
+}
+
+void unit_storage_test() {
+    std::cout << (check_slot_map() ? "SlotMap keeps its elements in place and its handles go stale" : "SlotMap DOESN'T keep its elements in place or its handles don't go stale") << std::endl;
+    std::cout << (check_team() ? "Units stay in place while the team changes" : "Units DON'T stay in place while the team changes") << std::endl;
+    std::cout << (check_game() ? "Units can be added to and removed from a running game" : "Units CAN'T be added to and removed from a running game") << std::endl;
+    benchmark_get_unit();
+}
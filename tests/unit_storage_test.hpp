@@ -0,0 +1,6 @@
+#ifndef UNIT_STORAGE_TEST_HPP
+#define UNIT_STORAGE_TEST_HPP
+
+void unit_storage_test();
+
+#endif //UNIT_STORAGE_TEST_HPP